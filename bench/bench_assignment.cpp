@@ -0,0 +1,177 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "bench/bench_util.hpp"
+#include "hlt/assignment.hpp"
+
+using namespace hlt;
+
+namespace {
+    Planet make_planet(const EntityId id, const double x, const double y, const double radius, const unsigned int spots) {
+        Planet planet;
+        planet.entity_id = id;
+        planet.owner_id = -1;
+        planet.owned = false;
+        planet.location = { x, y };
+        planet.radius = radius;
+        planet.health = (int) (radius * 255);
+        planet.docking_spots = spots;
+        planet.current_production = 0;
+        planet.remaining_production = (int) (radius * 100);
+        return planet;
+    }
+
+    Ship make_ship(const EntityId id, const Location& location) {
+        Ship ship;
+        ship.entity_id = id;
+        ship.owner_id = 0;
+        ship.location = location;
+        ship.health = 255;
+        ship.radius = constants::SHIP_RADIUS;
+        ship.docking_status = ShipDockingStatus::Undocked;
+        return ship;
+    }
+
+    std::vector<const Ship*> pointers(const std::vector<Ship>& ships) {
+        std::vector<const Ship*> result;
+        for (const Ship& ship : ships) {
+            result.push_back(&ship);
+        }
+        return result;
+    }
+
+    /// Total turns until docked of an assignment, counting unassigned ships as the assignment does.
+    double total_cost(const Map& map, const PlanetAssignment& assignment, const std::vector<const Ship*>& ships) {
+        const double none_cost = std::sqrt((double) map.map_width * map.map_width + (double) map.map_height * map.map_height)
+                                 / constants::MAX_SPEED + constants::DOCK_TURNS + 1;
+        double total = 0;
+        for (size_t i = 0; i < ships.size(); ++i) {
+            const Planet* planet = assignment.planet_of(i);
+            if (planet == nullptr) {
+                total += none_cost;
+                continue;
+            }
+            const double trip = ships[i]->location.get_distance_to(planet->location) - planet->radius - constants::DOCK_RADIUS;
+            total += std::max(0.0, trip) / constants::MAX_SPEED + constants::DOCK_TURNS;
+        }
+        return total;
+    }
+
+    /**
+     * Two ships fight over the near planet and push its price up; on the next
+     * turn a lone ship between both planets must still get the nearer one,
+     * not be kept from it by last turn's price.
+     */
+    void check_stale_prices() {
+        Map map(200, 100);
+        map.planets.push_back(make_planet(0, 50, 50, 3, 1));
+        map.planets.push_back(make_planet(1, 100, 50, 3, 1));
+        for (unsigned int p = 0; p < map.planets.size(); ++p) {
+            map.planet_map[map.planets[p].entity_id] = p;
+        }
+
+        PlanetAssignment assignment;
+        const std::vector<Ship> turn_1 = { make_ship(0, { 40, 50 }), make_ship(1, { 41, 50 }) };
+        assignment.solve(map, 0, pointers(turn_1));
+
+        const std::vector<Ship> turn_2 = { make_ship(2, { 70, 50 }) };
+        assignment.solve(map, 0, pointers(turn_2));
+        const Planet* planet = assignment.planet_of(0);
+        if (planet == nullptr || planet->entity_id != 0) {
+            std::fprintf(stderr, "stale prices: lone ship sent to planet %d instead of 0\n",
+                         planet == nullptr ? -1 : (int) planet->entity_id);
+            std::exit(1);
+        }
+    }
+
+    /// Ships drifting over several turns: with prices carried over, every turn is as good as a cold solve, give or take EPSILON per ship.
+    void check_warm_against_cold() {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        long turns = 0;
+
+        for (int game = 0; game < 200; ++game) {
+            const Map map = bench::make_map({ 240, 160, 2, 0, 4 + (int) (rng() % 12), (unsigned int) rng() });
+            std::vector<Ship> ships;
+            for (int i = 0; i < 1 + (int) (rng() % 40); ++i) {
+                ships.push_back(make_ship((EntityId) i, { unit(rng) * map.map_width, unit(rng) * map.map_height }));
+            }
+
+            PlanetAssignment warm;
+            for (int turn = 0; turn < 20; ++turn, ++turns) {
+                // Some ships come and go, the others move up to a turn's thrust.
+                std::vector<const Ship*> present;
+                for (Ship& ship : ships) {
+                    const double angle = unit(rng) * 2 * M_PI;
+                    const double thrust = unit(rng) * constants::MAX_SPEED;
+                    ship.location.pos_x = std::max(0.0, std::min((double) map.map_width, ship.location.pos_x + thrust * std::cos(angle)));
+                    ship.location.pos_y = std::max(0.0, std::min((double) map.map_height, ship.location.pos_y + thrust * std::sin(angle)));
+                    if (rng() % 5 != 0) {
+                        present.push_back(&ship);
+                    }
+                }
+
+                warm.solve(map, 0, present);
+                PlanetAssignment cold;
+                cold.solve(map, 0, present);
+                const double slack = (present.size() + 1) * PlanetAssignment::EPSILON + 1e-9;
+                if (total_cost(map, warm, present) > total_cost(map, cold, present) + slack) {
+                    std::fprintf(stderr, "warm start worse than cold: game %d turn %d, %.4f vs %.4f turns\n", game, turn,
+                                 total_cost(map, warm, present), total_cost(map, cold, present));
+                    std::exit(1);
+                }
+            }
+        }
+        std::printf("warm and cold solves agree over %ld turns\n", turns);
+    }
+
+    /// Time of a cold and a warm solve while the ships of spec move a turn's worth.
+    void time_solves(const bench::MapSpec& spec) {
+        Map map = bench::make_map(spec);
+        std::vector<Ship> ships;
+        for (const Ship& ship : map.ships.at(0)) {
+            if (ship.docking_status == ShipDockingStatus::Undocked) {
+                ships.push_back(ship);
+            }
+        }
+        const std::vector<const Ship*> present = pointers(ships);
+        std::mt19937 rng(spec.seed);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        const int turns = 50;
+
+        double cold_ms = 0;
+        double warm_ms = 0;
+        PlanetAssignment warm;
+        for (int turn = 0; turn < turns; ++turn) {
+            for (Ship& ship : ships) {
+                const double angle = unit(rng) * 2 * M_PI;
+                ship.location.pos_x += constants::MAX_SPEED * std::cos(angle) * unit(rng);
+                ship.location.pos_y += constants::MAX_SPEED * std::sin(angle) * unit(rng);
+            }
+            const bench::Stopwatch cold_timer;
+            PlanetAssignment cold;
+            cold.solve(map, 0, present);
+            cold_ms += cold_timer.elapsed_ms();
+
+            const bench::Stopwatch warm_timer;
+            warm.solve(map, 0, present);
+            warm_ms += warm_timer.elapsed_ms();
+            bench::sink += (long) (cold.bids() + warm.bids());
+        }
+
+        std::printf("%4dx%-4d ships=%4d planets=%3d | cold %7.3f ms | warm %7.3f ms (%4.1fx)\n",
+                    spec.width, spec.height, (int) ships.size(), (int) map.planets.size(),
+                    cold_ms / turns, warm_ms / turns, cold_ms / warm_ms);
+    }
+}
+
+int main() {
+    check_stale_prices();
+    check_warm_against_cold();
+    time_solves({ 240, 160, 2, 250, 20, 20 });
+    time_solves({ 384, 256, 4, 300, 28, 30 });
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "bench/bench_util.hpp"
+#include "hlt/collision.hpp"
+
+using namespace hlt;
+
+namespace {
+    struct Circles {
+        std::vector<double> x, y, radius;
+    };
+
+    Circles make_circles(std::mt19937& rng, const size_t count) {
+        std::uniform_real_distribution<double> coord(0.0, 384.0);
+        std::uniform_real_distribution<double> size(0.5, 16.0);
+        Circles circles;
+        for (size_t i = 0; i < count; ++i) {
+            circles.x.push_back(coord(rng));
+            circles.y.push_back(coord(rng));
+            circles.radius.push_back(i % 3 == 0 ? size(rng) : constants::SHIP_RADIUS);
+        }
+        return circles;
+    }
+
+    /// Segments of every length including zero, many of them grazing a circle boundary.
+    Location random_end(std::mt19937& rng, const Location& start, const Circles& circles) {
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        const double pick = unit(rng);
+        if (pick < 0.05) {
+            return start;
+        }
+        if (pick < 0.5) {
+            // Aim tangent to a random circle, right at the fudged boundary.
+            const size_t i = rng() % circles.x.size();
+            const Location center = { circles.x[i], circles.y[i] };
+            const double reach = circles.radius[i] + constants::FORECAST_FUDGE_FACTOR;
+            const double angle = start.orient_towards_in_rad(center) + M_PI / 2;
+            return { center.pos_x + reach * std::cos(angle), center.pos_y + reach * std::sin(angle) };
+        }
+        const double length = unit(rng) * 60;
+        const double angle = unit(rng) * 2 * M_PI;
+        return { start.pos_x + length * std::cos(angle), start.pos_y + length * std::sin(angle) };
+    }
+
+    void check_agreement() {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<double> coord(0.0, 384.0);
+        long checked = 0;
+        long hits = 0;
+
+        for (int round = 0; round < 2000; ++round) {
+            const Circles circles = make_circles(rng, 1 + rng() % 300);
+            const size_t count = circles.x.size();
+            std::vector<unsigned char> mask(count);
+
+            for (int query = 0; query < 50; ++query) {
+                const Location start = { coord(rng), coord(rng) };
+                const Location end = random_end(rng, start, circles);
+
+                collision::segment_circles_hit_mask(
+                        start, end, circles.x.data(), circles.y.data(), circles.radius.data(),
+                        count, constants::FORECAST_FUDGE_FACTOR, mask.data());
+
+                size_t expected_first = count;
+                for (size_t i = 0; i < count; ++i) {
+                    const bool expected = collision::segment_circle_intersect(
+                            start, end, { circles.x[i], circles.y[i] }, circles.radius[i],
+                            constants::FORECAST_FUDGE_FACTOR);
+                    if (expected != (mask[i] != 0)) {
+                        std::fprintf(stderr, "hit mask disagrees with segment_circle_intersect at circle %d\n", (int) i);
+                        std::exit(1);
+                    }
+                    if (expected && expected_first == count) {
+                        expected_first = i;
+                    }
+                    hits += expected;
+                }
+                ++checked;
+
+                const size_t first = collision::segment_circles_first_hit(
+                        start, end, circles.x.data(), circles.y.data(), circles.radius.data(),
+                        count, constants::FORECAST_FUDGE_FACTOR);
+                if (first != expected_first) {
+                    std::fprintf(stderr, "first hit %d, expected %d\n", (int) first, (int) expected_first);
+                    std::exit(1);
+                }
+            }
+        }
+
+        std::printf("agreement: %ld segments, %ld hits, batch width %d, all identical to scalar\n",
+                    checked, hits, (int) collision::BATCH_WIDTH);
+    }
+
+    void time_batch(const size_t count) {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<double> coord(0.0, 384.0);
+        const Circles circles = make_circles(rng, count);
+        std::vector<unsigned char> mask(count);
+
+        std::vector<Location> starts, ends;
+        for (int i = 0; i < 1000; ++i) {
+            starts.push_back({ coord(rng), coord(rng) });
+            ends.push_back(random_end(rng, starts.back(), circles));
+        }
+
+        long scalar_hits = 0;
+        const bench::Stopwatch scalar_timer;
+        for (size_t q = 0; q < starts.size(); ++q) {
+            for (size_t i = 0; i < count; ++i) {
+                scalar_hits += collision::segment_circle_intersect(
+                        starts[q], ends[q], { circles.x[i], circles.y[i] }, circles.radius[i],
+                        constants::FORECAST_FUDGE_FACTOR);
+            }
+        }
+        const double scalar_ms = scalar_timer.elapsed_ms();
+
+        long batch_hits = 0;
+        const bench::Stopwatch batch_timer;
+        for (size_t q = 0; q < starts.size(); ++q) {
+            batch_hits += (long) collision::segment_circles_hit_mask(
+                    starts[q], ends[q], circles.x.data(), circles.y.data(), circles.radius.data(),
+                    count, constants::FORECAST_FUDGE_FACTOR, mask.data());
+        }
+        const double batch_ms = batch_timer.elapsed_ms();
+
+        if (scalar_hits != batch_hits) {
+            std::fprintf(stderr, "hit counts differ\n");
+            std::exit(1);
+        }
+
+        const double tests = (double) starts.size() * count;
+        std::printf("circles=%5d | scalar %6.2f ns/test | batch %6.2f ns/test | %4.1fx\n",
+                    (int) count, scalar_ms * 1e6 / tests, batch_ms * 1e6 / tests, scalar_ms / batch_ms);
+    }
+}
+
+int main() {
+    check_agreement();
+    time_batch(64);
+    time_batch(600);
+    time_batch(1200);
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "bench/bench_util.hpp"
+#include "hlt/hlt_out.hpp"
+
+using namespace hlt;
+
+namespace {
+#ifdef _WIN32
+    const char* const NULL_DEVICE = "NUL";
+#else
+    const char* const NULL_DEVICE = "/dev/null";
+#endif
+
+    /// A turn of mostly thrusts, with some docks and undocks, as a big fleet sends.
+    std::vector<Move> make_turn(const int num_moves, const unsigned int seed) {
+        std::mt19937 rng(seed);
+        std::vector<Move> moves;
+        for (int i = 0; i < num_moves; ++i) {
+            const EntityId ship_id = (EntityId) (rng() % 5000);
+            const unsigned int kind = rng() % 10;
+            if (kind == 0) {
+                moves.push_back(Move::dock(ship_id, (EntityId) (rng() % 60)));
+            } else if (kind == 1) {
+                moves.push_back(Move::undock(ship_id));
+            } else {
+                moves.push_back(Move::thrust(ship_id, (int) (rng() % 8), (int) (rng() % 360)));
+            }
+        }
+        return moves;
+    }
+
+    void run(const int num_moves) {
+        std::vector<std::vector<Move>> turns;
+        for (unsigned int seed = 1; seed <= 10; ++seed) {
+            turns.push_back(make_turn(num_moves, seed));
+        }
+        turns.back().push_back(Move::noop());
+
+        out::MoveEncoder encoder;
+        for (const std::vector<Move>& moves : turns) {
+            encoder.encode(moves);
+            if (std::string(encoder.data(), encoder.size()) != out::format_moves_stream(moves)) {
+                std::fprintf(stderr, "%d moves: MoveEncoder disagrees with the iostream encoder\n", num_moves);
+                std::exit(1);
+            }
+        }
+
+        const int rounds = 200;
+        const double count = (double) turns.size() * rounds;
+
+        // Encoding alone.
+        const bench::Stopwatch stream_format_timer;
+        for (int round = 0; round < rounds; ++round) {
+            for (const std::vector<Move>& moves : turns) {
+                bench::sink += (long) out::format_moves_stream(moves).size();
+            }
+        }
+        const double stream_format_ms = stream_format_timer.elapsed_ms();
+
+        const bench::Stopwatch format_timer;
+        for (int round = 0; round < rounds; ++round) {
+            for (const std::vector<Move>& moves : turns) {
+                encoder.encode(moves);
+                bench::sink += (long) encoder.size();
+            }
+        }
+        const double format_ms = format_timer.elapsed_ms();
+
+        // Encoding and sending: the old ostringstream and std::endl path against one write.
+        std::ofstream stream(NULL_DEVICE);
+        const bench::Stopwatch stream_send_timer;
+        for (int round = 0; round < rounds; ++round) {
+            for (const std::vector<Move>& moves : turns) {
+                // The reference line already ends in the newline std::endl used to add.
+                stream << out::format_moves_stream(moves) << std::flush;
+            }
+        }
+        const double stream_send_ms = stream_send_timer.elapsed_ms();
+
+#ifdef _WIN32
+        const int fd = _open(NULL_DEVICE, _O_WRONLY);
+#else
+        const int fd = open(NULL_DEVICE, O_WRONLY);
+#endif
+        const bench::Stopwatch send_timer;
+        for (int round = 0; round < rounds; ++round) {
+            for (const std::vector<Move>& moves : turns) {
+                encoder.encode(moves);
+                if (!out::write_all(fd, encoder.data(), encoder.size())) {
+                    std::fprintf(stderr, "write to %s failed\n", NULL_DEVICE);
+                    std::exit(1);
+                }
+            }
+        }
+        const double send_ms = send_timer.elapsed_ms();
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+
+        std::printf("%5d moves/turn %6.1f KB/turn | encode: iostream %7.1f us, MoveEncoder %6.1f us (%5.1fx)"
+                    " | encode+send: ostringstream+endl %7.1f us, one write %6.1f us (%5.1fx)\n",
+                    num_moves, encoder.size() / 1024.0,
+                    stream_format_ms * 1000 / count, format_ms * 1000 / count, stream_format_ms / format_ms,
+                    stream_send_ms * 1000 / count, send_ms * 1000 / count, stream_send_ms / send_ms);
+    }
+}
+
+/**
+ * Time the move encoder against the iostream one on large turns, after
+ * checking that both produce the same line.
+ */
+int main() {
+    run(100);
+    run(1000);
+    run(5000);
+    return 0;
+}
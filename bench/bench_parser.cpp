@@ -0,0 +1,88 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bench/bench_util.hpp"
+#include "hlt/hlt_in.hpp"
+
+using namespace hlt;
+
+namespace {
+    void run(const char* name, const std::vector<std::string>& frames, const int width, const int height) {
+        size_t bytes = 0;
+        for (const std::string& frame : frames) {
+            bytes += frame.size();
+            if (!bench::same_map(in::parse_map_stream(frame, width, height), in::parse_map(frame, width, height))) {
+                std::fprintf(stderr, "%s: parse_map disagrees with the stringstream parser\n", name);
+                std::exit(1);
+            }
+        }
+
+        const int rounds = 50;
+
+        const bench::Stopwatch stream_timer;
+        for (int round = 0; round < rounds; ++round) {
+            for (const std::string& frame : frames) {
+                bench::sink += (long) in::parse_map_stream(frame, width, height).planets.size();
+            }
+        }
+        const double stream_ms = stream_timer.elapsed_ms();
+
+        const bench::Stopwatch fast_timer;
+        for (int round = 0; round < rounds; ++round) {
+            for (const std::string& frame : frames) {
+                bench::sink += (long) in::parse_map(frame, width, height).planets.size();
+            }
+        }
+        const double fast_ms = fast_timer.elapsed_ms();
+
+        const double count = (double) frames.size() * rounds;
+        const double megabytes = (double) bytes * rounds / (1024 * 1024);
+        std::printf("%-28s frames=%4d avg=%7.1f KB | stringstream %8.1f us/frame %6.1f MB/s"
+                    " | in place %8.1f us/frame %6.1f MB/s | %5.1fx\n",
+                    name, (int) frames.size(), bytes / 1024.0 / frames.size(),
+                    stream_ms * 1000 / count, megabytes / (stream_ms / 1000),
+                    fast_ms * 1000 / count, megabytes / (fast_ms / 1000), stream_ms / fast_ms);
+    }
+
+    void run_synthetic(const char* name, bench::MapSpec spec) {
+        std::vector<std::string> frames;
+        for (int i = 0; i < 10; ++i) {
+            frames.push_back(sim::write_frame(bench::make_map(spec)));
+            ++spec.seed;
+        }
+        run(name, frames, spec.width, spec.height);
+    }
+}
+
+/**
+ * Usage: bench_parser [frames_file width height]
+ *
+ * Without arguments, parses synthetic frames. Given a file with one recorded
+ * frame per line, parses those instead.
+ */
+int main(int argc, char** argv) {
+    if (argc == 4) {
+        std::ifstream file(argv[1]);
+        std::vector<std::string> frames;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty()) {
+                frames.push_back(line);
+            }
+        }
+        if (frames.empty()) {
+            std::fprintf(stderr, "no frames in %s\n", argv[1]);
+            return 1;
+        }
+        run(argv[1], frames, std::atoi(argv[2]), std::atoi(argv[3]));
+        return 0;
+    }
+
+    run_synthetic("240x160 2p early", { 240, 160, 2, 3, 12, 10 });
+    run_synthetic("240x160 2p 500 ships", { 240, 160, 2, 250, 20, 20 });
+    run_synthetic("384x256 4p 1200 ships", { 384, 256, 4, 300, 28, 30 });
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "bench/bench_util.hpp"
+#include "hlt/distance_cache.hpp"
+#include "hlt/move_planner.hpp"
+#include "hlt/worker_pool.hpp"
+
+using namespace hlt;
+
+namespace {
+    struct Path {
+        Location start;
+        Location end;
+    };
+
+    /// Closest approach of two ships moving along their paths at the same time, by brute force.
+    double closest_approach(const Path& a, const Path& b) {
+        double closest = 1e9;
+        const int steps = 200;
+        for (int step = 0; step <= steps; ++step) {
+            const double t = (double) step / steps;
+            const double dx = (a.start.pos_x + (a.end.pos_x - a.start.pos_x) * t)
+                              - (b.start.pos_x + (b.end.pos_x - b.start.pos_x) * t);
+            const double dy = (a.start.pos_y + (a.end.pos_y - a.start.pos_y) * t)
+                              - (b.start.pos_y + (b.end.pos_y - b.start.pos_y) * t);
+            closest = std::min(closest, std::sqrt(dx * dx + dy * dy));
+        }
+        return closest;
+    }
+
+    /// Every undocked ship of player 0 asks for its three nearest planets, as MyBot's miners do.
+    void request_all(const Map& map, DistanceCache& distances, MovePlanner& planner, WorkerPool& workers) {
+        const std::vector<Ship>& ships = map.ships.at(0);
+        planner.reset(ships.size());
+        workers.run(ships.size(), [&](const size_t i) {
+            if (ships[i].docking_status != ShipDockingStatus::Undocked) {
+                return;
+            }
+            planner.request(i, ships[i], 0);
+            for (const Planet* planet : distances.nearest_planets(ships[i], 3)) {
+                planner.add_dock_target(i, *planet, constants::MAX_SPEED);
+            }
+        });
+    }
+
+    /// Average time of a whole turn (begin_turn, requests and plan) with the given number of threads.
+    double time_turns(const Map& map, const int threads, std::vector<Move>& moves) {
+        const std::shared_ptr<WorkerPool> workers = std::make_shared<WorkerPool>(threads);
+        MovePlanner planner(workers);
+        const int rounds = 20;
+
+        double plan_ms = 0;
+        for (int round = 0; round < rounds; ++round) {
+            DistanceCache distances(map, 0);
+            moves.clear();
+            TurnTimer::start(constants::TURN_TIME_LIMIT_MS);
+            const bench::Stopwatch timer;
+            navigation::begin_turn(map);
+            request_all(map, distances, planner, *workers);
+            planner.plan(map, moves);
+            plan_ms += timer.elapsed_ms();
+        }
+        return plan_ms / rounds;
+    }
+
+    bool same_moves(const std::vector<Move>& a, const std::vector<Move>& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (a[i].type != b[i].type || a[i].ship_id != b[i].ship_id
+                || a[i].move_thrust != b[i].move_thrust || a[i].move_angle_deg != b[i].move_angle_deg) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void run(const bench::MapSpec& spec, const int threads) {
+        const Map map = bench::make_map(spec);
+        std::vector<Move> moves;
+        const double serial_ms = time_turns(map, 1, moves);
+        std::vector<Move> parallel_moves;
+        const double parallel_ms = time_turns(map, threads, parallel_moves);
+        if (!same_moves(moves, parallel_moves)) {
+            std::fprintf(stderr, "%dx%d: moves differ between 1 and %d threads\n", spec.width, spec.height, threads);
+            std::exit(1);
+        }
+
+        std::vector<Path> paths;
+        int undocked = 0;
+        for (const Ship& ship : map.ships.at(0)) {
+            undocked += ship.docking_status == ShipDockingStatus::Undocked;
+        }
+        for (const Move& move : moves) {
+            const Ship& ship = map.get_ship(0, move.ship_id);
+            paths.push_back({ ship.location, navigation::toLocation(ship.location, move.move_thrust, move.move_angle_deg) });
+        }
+        int conflicts = 0;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            for (size_t j = i + 1; j < paths.size(); ++j) {
+                conflicts += closest_approach(paths[i], paths[j]) < 2 * constants::SHIP_RADIUS;
+            }
+        }
+        if (conflicts > 0) {
+            std::fprintf(stderr, "%dx%d: %d pairs of planned paths collide\n", spec.width, spec.height, conflicts);
+            std::exit(1);
+        }
+
+        std::printf("%4dx%-4d my ships=%4d undocked=%4d moved=%4d | 1 thread %7.3f ms/turn,"
+                    " %d threads %7.3f ms/turn (%4.1fx), same moves, 0 colliding pairs\n",
+                    spec.width, spec.height, (int) map.ships.at(0).size(), undocked, (int) moves.size(),
+                    serial_ms, threads, parallel_ms, serial_ms / parallel_ms);
+    }
+}
+
+int main(int argc, char** argv) {
+    const int threads = argc > 1 ? std::max(1, std::atoi(argv[1])) : WorkerPool::default_threads();
+    run({ 240, 160, 2, 150, 20, 1 }, threads);
+    run({ 240, 160, 2, 400, 20, 2 }, threads);
+    run({ 384, 256, 2, 320, 28, 3 }, threads);
+    run({ 384, 256, 4, 400, 28, 4 }, threads);
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench/bench_util.hpp"
+#include "hlt/navigation.hpp"
+#include "hlt/planet_grid.hpp"
+
+using namespace hlt;
+
+namespace {
+    struct Segment {
+        Location start;
+        Location target;
+    };
+
+    /// Every undocked ship heading for a random planet, as navigate_ship_to_dock would ask.
+    std::vector<Segment> make_segments(const Map& map, const unsigned int seed) {
+        std::mt19937 rng(seed);
+        std::vector<Segment> segments;
+        for (const auto& player_ships : map.ships) {
+            for (const Ship& ship : player_ships.second) {
+                if (ship.docking_status != ShipDockingStatus::Undocked) {
+                    continue;
+                }
+                const Planet& planet = map.planets[rng() % map.planets.size()];
+                segments.push_back({ ship.location, ship.location.get_closest_point(planet.location, planet.radius) });
+            }
+        }
+        return segments;
+    }
+
+    void run(const bench::MapSpec& spec) {
+        const Map map = bench::make_map(spec);
+        const std::vector<Segment> segments = make_segments(map, spec.seed);
+        const int rounds = 20;
+
+        long linear_hits = 0;
+        const bench::Stopwatch linear_timer;
+        for (int round = 0; round < rounds; ++round) {
+            for (const Segment& segment : segments) {
+                linear_hits += !navigation::objects_between(map, segment.start, segment.target).empty();
+            }
+        }
+        const double linear_ms = linear_timer.elapsed_ms();
+
+        SpatialIndex index;
+        const bench::Stopwatch build_timer;
+        for (int round = 0; round < rounds; ++round) {
+            index.build(map);
+        }
+        const double build_ms = build_timer.elapsed_ms() / rounds;
+
+        long indexed_hits = 0;
+        const bench::Stopwatch indexed_timer;
+        for (int round = 0; round < rounds; ++round) {
+            for (const Segment& segment : segments) {
+                indexed_hits += index.any_between(segment.start, segment.target);
+            }
+        }
+        const double indexed_ms = indexed_timer.elapsed_ms();
+
+        long listed_hits = 0;
+        const bench::Stopwatch listed_timer;
+        for (int round = 0; round < rounds; ++round) {
+            for (const Segment& segment : segments) {
+                listed_hits += (long) index.objects_between(segment.start, segment.target).size();
+            }
+        }
+        const double listed_ms = listed_timer.elapsed_ms();
+
+        long linear_listed = 0;
+        for (const Segment& segment : segments) {
+            linear_listed += (long) navigation::objects_between(map, segment.start, segment.target).size();
+        }
+        // Planets from a PlanetGrid, so the index only registers ships each turn.
+        PlanetGrid planet_grid;
+        planet_grid.update(map);
+        SpatialIndex ship_index;
+        const bench::Stopwatch ship_build_timer;
+        for (int round = 0; round < rounds; ++round) {
+            ship_index.build(map, &planet_grid);
+        }
+        const double ship_build_ms = ship_build_timer.elapsed_ms() / rounds;
+
+        long gridded_hits = 0;
+        const bench::Stopwatch gridded_timer;
+        for (int round = 0; round < rounds; ++round) {
+            for (const Segment& segment : segments) {
+                gridded_hits += ship_index.any_between(segment.start, segment.target);
+            }
+        }
+        const double gridded_ms = gridded_timer.elapsed_ms();
+
+        long gridded_listed = 0;
+        for (const Segment& segment : segments) {
+            gridded_listed += (long) ship_index.objects_between(segment.start, segment.target).size();
+        }
+
+        if (linear_hits != indexed_hits || linear_listed * rounds != listed_hits
+            || linear_hits != gridded_hits || linear_listed != gridded_listed) {
+            std::fprintf(stderr, "mismatch between linear scan and index\n");
+            std::exit(1);
+        }
+
+        const double queries = (double) segments.size() * rounds;
+        std::printf("%4dx%-4d ships=%5d planets=%3d | linear %7.3f us | index build %6.3f ms,"
+                    " any %6.3f us (%5.1fx), all %6.3f us (%5.1fx)"
+                    " | planet grid: build %6.3f ms, any %6.3f us (%5.1fx)\n",
+                    spec.width, spec.height, bench::count_ships(map), (int) map.planets.size(),
+                    linear_ms * 1000 / queries, build_ms,
+                    indexed_ms * 1000 / queries, linear_ms / indexed_ms,
+                    listed_ms * 1000 / queries, linear_ms / listed_ms,
+                    ship_build_ms, gridded_ms * 1000 / queries, linear_ms / gridded_ms);
+    }
+}
+
+int main() {
+    run({ 240, 160, 2, 250, 20, 1 });
+    run({ 240, 160, 4, 150, 20, 2 });
+    run({ 384, 256, 4, 150, 28, 3 });
+    run({ 384, 256, 4, 300, 28, 4 });
+    return 0;
+}
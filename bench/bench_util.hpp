@@ -0,0 +1,183 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "hlt/map.hpp"
+#include "sim/frame.hpp"
+
+namespace bench {
+    /// Shape of a generated map.
+    struct MapSpec {
+        int width;
+        int height;
+        int num_players;
+        int ships_per_player;
+        int num_planets;
+        unsigned int seed;
+    };
+
+    /**
+     * Build a reproducible mid/late-game map: non-overlapping planets, about a
+     * third of them owned with docked ships, and the remaining ships scattered
+     * over open space.
+     */
+    static hlt::Map make_map(const MapSpec& spec) {
+        std::mt19937 rng(spec.seed);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+        hlt::Map map(spec.width, spec.height);
+
+        for (int i = 0; i < spec.num_planets * 20 && (int) map.planets.size() < spec.num_planets; ++i) {
+            hlt::Planet planet;
+            planet.radius = 3.0 + 9.0 * unit(rng);
+            planet.location.pos_x = planet.radius + 2 + unit(rng) * (spec.width - 2 * planet.radius - 4);
+            planet.location.pos_y = planet.radius + 2 + unit(rng) * (spec.height - 2 * planet.radius - 4);
+
+            bool overlaps = false;
+            for (const hlt::Planet& other : map.planets) {
+                if (planet.location.get_distance_to(other.location) < planet.radius + other.radius + 8) {
+                    overlaps = true;
+                    break;
+                }
+            }
+            if (overlaps) {
+                continue;
+            }
+
+            planet.entity_id = (hlt::EntityId) map.planets.size();
+            planet.owner_id = -1;
+            planet.owned = false;
+            planet.health = (int) (planet.radius * 255);
+            planet.docking_spots = (unsigned int) (planet.radius / 3);
+            planet.current_production = 0;
+            planet.remaining_production = (int) (planet.radius * 100);
+            map.planet_map[planet.entity_id] = (unsigned int) map.planets.size();
+            map.planets.push_back(planet);
+        }
+
+        hlt::EntityId next_ship_id = 0;
+        for (hlt::PlayerId player_id = 0; player_id < spec.num_players; ++player_id) {
+            std::vector<hlt::Ship>& ships = map.ships[player_id];
+            hlt::entity_map<unsigned int>& ship_map = map.ship_map[player_id];
+
+            for (int i = 0; i < spec.ships_per_player; ++i) {
+                hlt::Ship ship;
+                ship.entity_id = next_ship_id++;
+                ship.owner_id = player_id;
+                ship.health = hlt::constants::BASE_SHIP_HEALTH;
+                ship.radius = hlt::constants::SHIP_RADIUS;
+                ship.weapon_cooldown = 0;
+                ship.docking_status = hlt::ShipDockingStatus::Undocked;
+                ship.docking_progress = 0;
+                ship.docked_planet = 0;
+
+                hlt::Planet& planet = map.planets[rng() % map.planets.size()];
+                const bool may_dock = !planet.owned || planet.owner_id == player_id;
+                if (may_dock && planet.docked_ships.size() < planet.docking_spots && unit(rng) < 0.3) {
+                    const double angle = unit(rng) * 2 * M_PI;
+                    ship.location.pos_x = planet.location.pos_x + (planet.radius + 1) * std::cos(angle);
+                    ship.location.pos_y = planet.location.pos_y + (planet.radius + 1) * std::sin(angle);
+                    ship.docking_status = hlt::ShipDockingStatus::Docked;
+                    ship.docked_planet = planet.entity_id;
+                    planet.owned = true;
+                    planet.owner_id = player_id;
+                    planet.docked_ships.push_back(ship.entity_id);
+                } else {
+                    bool free = false;
+                    while (!free) {
+                        ship.location.pos_x = unit(rng) * spec.width;
+                        ship.location.pos_y = unit(rng) * spec.height;
+                        free = true;
+                        for (const hlt::Planet& other : map.planets) {
+                            if (ship.location.get_distance_to(other.location) < other.radius + 1) {
+                                free = false;
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                ship_map[ship.entity_id] = (unsigned int) ships.size();
+                ships.push_back(ship);
+            }
+        }
+
+        return map;
+    }
+
+    static int count_ships(const hlt::Map& map) {
+        int count = 0;
+        for (const auto& player_ships : map.ships) {
+            count += (int) player_ships.second.size();
+        }
+        return count;
+    }
+
+    static bool same_bits(const double a, const double b) {
+        return std::memcmp(&a, &b, sizeof(double)) == 0;
+    }
+
+    static bool same_entity(const hlt::Entity& a, const hlt::Entity& b) {
+        return a.entity_id == b.entity_id && a.owner_id == b.owner_id && a.health == b.health
+               && same_bits(a.radius, b.radius)
+               && same_bits(a.location.pos_x, b.location.pos_x)
+               && same_bits(a.location.pos_y, b.location.pos_y);
+    }
+
+    /// Field-by-field equality, including bit-identical coordinates and consistent id maps.
+    static bool same_map(const hlt::Map& a, const hlt::Map& b) {
+        if (a.ships.size() != b.ships.size() || a.planets.size() != b.planets.size()
+            || a.planet_map.size() != b.planet_map.size()) {
+            return false;
+        }
+        for (const auto& player_ships : a.ships) {
+            const std::vector<hlt::Ship>& other = b.ships.at(player_ships.first);
+            if (other.size() != player_ships.second.size()
+                || b.ship_map.at(player_ships.first).size() != other.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < other.size(); ++i) {
+                const hlt::Ship& x = player_ships.second[i];
+                const hlt::Ship& y = other[i];
+                if (!same_entity(x, y) || x.weapon_cooldown != y.weapon_cooldown
+                    || x.docking_status != y.docking_status || x.docking_progress != y.docking_progress
+                    || x.docked_planet != y.docked_planet
+                    || b.ship_map.at(player_ships.first).at(x.entity_id) != i) {
+                    return false;
+                }
+            }
+        }
+        for (size_t i = 0; i < a.planets.size(); ++i) {
+            const hlt::Planet& x = a.planets[i];
+            const hlt::Planet& y = b.planets[i];
+            if (!same_entity(x, y) || x.owned != y.owned || x.remaining_production != y.remaining_production
+                || x.current_production != y.current_production || x.docking_spots != y.docking_spots
+                || x.docked_ships != y.docked_ships || b.planet_map.at(x.entity_id) != i) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Wall-clock timer for a benchmark section.
+    class Stopwatch {
+    public:
+        Stopwatch() : started(std::chrono::steady_clock::now()) {
+        }
+
+        double elapsed_ms() const {
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+            return elapsed.count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point started;
+    };
+
+    /// Keeps the optimizer from discarding a benchmarked result.
+    static volatile long sink;
+}
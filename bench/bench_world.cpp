@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "bench/bench_util.hpp"
+#include "hlt/hlt_in.hpp"
+#include "hlt/world.hpp"
+#include "sim/game.hpp"
+#include "sim/map_generator.hpp"
+#include "strategies/my_bot.hpp"
+#include "strategies/up_close.hpp"
+
+using namespace hlt;
+
+namespace {
+    long allocations = 0;
+}
+
+void* operator new(const std::size_t size) {
+    ++allocations;
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC pairs the malloc above with a delete it inlined elsewhere and warns; the pair is right.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+namespace {
+    /// The frames of one simulated game between two linked-in bots.
+    std::vector<std::string> record_game(const int width, const int height, const int num_players, const unsigned int seed) {
+        sim::Game game(sim::generator::generate_map(width, height, num_players, seed), num_players,
+                       sim::Game::default_max_turns(width, height));
+        std::vector<strategies::Strategy> bots;
+        for (PlayerId player_id = 0; player_id < num_players; ++player_id) {
+            bots.push_back(player_id % 2 == 0 ? strategies::my_bot::create(player_id, game.map())
+                                              : strategies::up_close::create(player_id, game.map()));
+        }
+
+        std::vector<std::string> frames;
+        std::vector<std::vector<Move>> moves((size_t) num_players);
+        while (!game.is_over()) {
+            frames.push_back(game.frame());
+            for (PlayerId player_id = 0; player_id < num_players; ++player_id) {
+                moves[player_id].clear();
+                if (game.is_alive(player_id)) {
+                    bots[player_id](game.map(), moves[player_id]);
+                }
+            }
+            game.step(moves);
+        }
+        return frames;
+    }
+
+    void run(const char* name, const int width, const int height, const int num_players, const unsigned int seed) {
+        const std::vector<std::string> frames = record_game(width, height, num_players, seed);
+
+        World world(width, height);
+        int previous_ships = 0;
+        for (const std::string& frame : frames) {
+            world.update(frame);
+            if (!bench::same_map(in::parse_map(frame, width, height), world.map())) {
+                std::fprintf(stderr, "%s: World disagrees with parse_map\n", name);
+                std::exit(1);
+            }
+            const World::Delta& delta = world.delta();
+            const int ships = bench::count_ships(world.map());
+            if (ships != previous_ships + (int) delta.spawned.size() - (int) delta.destroyed.size()) {
+                std::fprintf(stderr, "%s: spawned/destroyed do not add up\n", name);
+                std::exit(1);
+            }
+            previous_ships = ships;
+        }
+
+        // Allocations after the first few turns, once the containers have grown.
+        const size_t warmup = std::min<size_t>(10, frames.size());
+        World steady(width, height);
+        long steady_allocations = 0;
+        int turns_without = 0;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            const long before = allocations;
+            steady.update(frames[i]);
+            if (i >= warmup) {
+                steady_allocations += allocations - before;
+                turns_without += allocations == before;
+            }
+        }
+
+        const int rounds = 20;
+        long parse_allocations = allocations;
+        const bench::Stopwatch parse_timer;
+        for (int round = 0; round < rounds; ++round) {
+            for (const std::string& frame : frames) {
+                bench::sink += (long) in::parse_map(frame, width, height).planets.size();
+            }
+        }
+        const double parse_ms = parse_timer.elapsed_ms();
+        parse_allocations = allocations - parse_allocations;
+
+        const bench::Stopwatch update_timer;
+        for (int round = 0; round < rounds; ++round) {
+            World timed(width, height);
+            for (const std::string& frame : frames) {
+                timed.update(frame);
+                bench::sink += (long) timed.map().planets.size();
+            }
+        }
+        const double update_ms = update_timer.elapsed_ms();
+
+        // Whole bot turns, World::update included, for player 0.
+        World bot_world(width, height);
+        bot_world.update(frames[0]);
+        strategies::my_bot::Bot bot(0, bot_world.map());
+        std::vector<Move> moves;
+        long bot_allocations = 0;
+        int bot_turns_without = 0;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            const long before = allocations;
+            bot_world.update(frames[i]);
+            moves.clear();
+            if (bot_world.map().ships.count(0) && !bot_world.map().ships.at(0).empty()) {
+                bot(bot_world.map(), moves);
+            }
+            if (i >= warmup) {
+                bot_allocations += allocations - before;
+                bot_turns_without += allocations == before;
+            }
+        }
+
+        const double count = (double) frames.size() * rounds;
+        const size_t measured = frames.size() - warmup;
+        std::printf("%-24s turns=%4d | parse_map %7.1f us/turn %7.1f allocs/turn"
+                    " | World::update %7.1f us/turn %5.2f allocs/turn, %d/%d turns alloc-free | %4.1fx\n",
+                    name, (int) frames.size(), parse_ms * 1000 / count, parse_allocations / count,
+                    update_ms * 1000 / count, measured ? (double) steady_allocations / measured : 0.0,
+                    turns_without, (int) measured, parse_ms / update_ms);
+        std::printf("%-24s MyBot turn %5.2f allocs/turn, %d/%d turns alloc-free, peak turn memory %6.1f KB\n",
+                    "", measured ? (double) bot_allocations / measured : 0.0, bot_turns_without, (int) measured,
+                    bot.peak_turn_bytes() / 1024.0);
+    }
+}
+
+int main() {
+    // Worker threads would only add their own warm-up allocations to the counts.
+    WorkerPool::set_default_threads(1);
+    run("240x160 2p", 240, 160, 2, 1);
+    run("384x256 4p", 384, 256, 4, 2);
+    return 0;
+}
@@ -0,0 +1,501 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <random>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench/bench_util.hpp"
+#include "hlt/arena.hpp"
+#include "hlt/assignment.hpp"
+#include "hlt/distance_cache.hpp"
+#include "hlt/entity_store.hpp"
+#include "hlt/flow_field.hpp"
+#include "hlt/forward_model.hpp"
+#include "hlt/hlt_in.hpp"
+#include "hlt/hlt_out.hpp"
+#include "hlt/kinematics.hpp"
+#include "hlt/navigation.hpp"
+#include "hlt/planet_grid.hpp"
+#include "hlt/threat_field.hpp"
+#include "hlt/visibility_graph.hpp"
+#include "hlt/world.hpp"
+#include "sim/frame.hpp"
+
+using namespace hlt;
+
+namespace {
+    /**
+     * One benchmark: body(n) does the measured work n times. items is how
+     * many ships, segments or moves one repetition of the work covers.
+     */
+    struct Benchmark {
+        std::string name;
+        long items;
+        std::function<void(long)> body;
+    };
+
+    struct Result {
+        std::string name;
+        long iterations;
+        double real_ns;
+        double cpu_ns;
+        long items;
+    };
+
+    /// A synthetic map, with its frame and the work the benchmarks replay on it.
+    struct Fixture {
+        const char* name;
+        Map map;
+        std::string frame;
+        std::vector<const Ship*> undocked;
+        /// For each of undocked, a planet to head for.
+        std::vector<const Planet*> targets;
+        std::vector<Move> moves;
+        ForwardState state;
+        /// A turn of commands for every player: each undocked ship thrusts somewhere.
+        std::vector<std::vector<Move>> all_moves;
+
+        Fixture(const char* name, const bench::MapSpec& spec) :
+                name(name), map(bench::make_map(spec)), frame(sim::write_frame(map)), state(map, spec.num_players) {
+            std::mt19937 rng(spec.seed);
+            for (const Ship& ship : map.ships.at(0)) {
+                if (ship.docking_status != ShipDockingStatus::Undocked) {
+                    continue;
+                }
+                undocked.push_back(&ship);
+                targets.push_back(&map.planets[rng() % map.planets.size()]);
+                moves.push_back(Move::thrust(ship.entity_id, (int) (rng() % 8), (int) (rng() % 360)));
+            }
+            all_moves.resize((size_t) spec.num_players);
+            for (PlayerId player_id = 0; player_id < spec.num_players; ++player_id) {
+                for (const Ship& ship : map.ships.at(player_id)) {
+                    if (ship.docking_status == ShipDockingStatus::Undocked) {
+                        all_moves[player_id].push_back(
+                                Move::thrust(ship.entity_id, (int) (rng() % 8), (int) (rng() % 360)));
+                    }
+                }
+            }
+        }
+
+        /// The map's flow fields, built on first use: too slow to build again in every benchmark's setup.
+        const FlowFields& flow_fields() const {
+            if (!flows) {
+                flows.reset(new FlowFields(map));
+            }
+            return *flows;
+        }
+
+        // The pointers above point into map.
+        Fixture(const Fixture&) = delete;
+
+    private:
+        mutable std::unique_ptr<FlowFields> flows;
+    };
+
+    std::vector<Benchmark> make_benchmarks(const Fixture& fixture) {
+        const std::string suffix = std::string("/") + fixture.name;
+        const Fixture* f = &fixture;
+        const long num_ships = (long) fixture.undocked.size();
+        std::vector<Benchmark> benchmarks;
+
+        benchmarks.push_back({ "parse_map" + suffix, 1, [f](const long n) {
+            for (long i = 0; i < n; ++i) {
+                bench::sink += (long) in::parse_map(f->frame, f->map.map_width, f->map.map_height).planets.size();
+            }
+        } });
+
+        benchmarks.push_back({ "world_update" + suffix, 1, [f](const long n) {
+            World world(f->map.map_width, f->map.map_height);
+            for (long i = 0; i < n; ++i) {
+                world.update(f->frame);
+                bench::sink += (long) world.map().planets.size();
+            }
+        } });
+
+        // Every undocked ship of player 0 ranks all planets, as MyBot's miners do.
+        benchmarks.push_back({ "distance_sort" + suffix, num_ships, [f](const long n) {
+            Arena arena;
+            for (long i = 0; i < n; ++i) {
+                arena.reset();
+                DistanceCache distances(f->map, 0, &arena);
+                for (const Ship* ship : f->undocked) {
+                    bench::sink += (long) (*distances.planets_by_distance(*ship).begin())->entity_id;
+                }
+            }
+        } });
+
+        benchmarks.push_back({ "objects_between" + suffix, num_ships, [f](const long n) {
+            for (long i = 0; i < n; ++i) {
+                for (size_t s = 0; s < f->undocked.size(); ++s) {
+                    const Location& start = f->undocked[s]->location;
+                    const Location target = start.get_closest_point(f->targets[s]->location, f->targets[s]->radius);
+                    bench::sink += (long) navigation::objects_between(f->map, start, target).size();
+                }
+            }
+        } });
+
+        benchmarks.push_back({ "any_object_between_indexed" + suffix, num_ships, [f](const long n) {
+            navigation::begin_turn(f->map);
+            for (long i = 0; i < n; ++i) {
+                for (size_t s = 0; s < f->undocked.size(); ++s) {
+                    const Location& start = f->undocked[s]->location;
+                    const Location target = start.get_closest_point(f->targets[s]->location, f->targets[s]->radius);
+                    bench::sink += navigation::any_object_between(f->map, start, target);
+                }
+            }
+        } });
+
+        benchmarks.push_back({ "planet_grid_build" + suffix, (long) fixture.map.planets.size(), [f](const long n) {
+            for (long i = 0; i < n; ++i) {
+                PlanetGrid grid;
+                grid.update(f->map);
+                bench::sink += (long) grid.num_occupied_cells();
+            }
+        } });
+
+        // Only the planets of each dock path, which is all the grid answers.
+        benchmarks.push_back({ "planet_grid_any_between" + suffix, num_ships, [f](const long n) {
+            PlanetGrid grid;
+            grid.update(f->map);
+            for (long i = 0; i < n; ++i) {
+                for (size_t s = 0; s < f->undocked.size(); ++s) {
+                    const Location& start = f->undocked[s]->location;
+                    const Location target = start.get_closest_point(f->targets[s]->location, f->targets[s]->radius);
+                    bench::sink += grid.any_between(start, target);
+                }
+            }
+        } });
+
+        // A whole turn of navigation: fresh reservations, then every undocked ship docks somewhere.
+        benchmarks.push_back({ "navigate_to_dock" + suffix, num_ships, [f](const long n) {
+            for (long i = 0; i < n; ++i) {
+                TurnTimer::start(constants::TURN_TIME_LIMIT_MS);
+                navigation::begin_turn(f->map);
+                for (size_t s = 0; s < f->undocked.size(); ++s) {
+                    bench::sink += navigation::navigate_ship_to_dock(
+                            f->map, *f->undocked[s], *f->targets[s], constants::MAX_SPEED).second;
+                }
+            }
+        } });
+
+        // Every endpoint of the discrete move space, for every undocked ship of player 0.
+        benchmarks.push_back({ "move_endpoints" + suffix, num_ships, [f](const long n) {
+            for (long i = 0; i < n; ++i) {
+                double sum = 0;
+                for (const Ship* ship : f->undocked) {
+                    for (int thrust = 1; thrust <= constants::MAX_SPEED; ++thrust) {
+                        for (int angle_deg = 0; angle_deg < kinematics::NUM_HEADINGS; ++angle_deg) {
+                            sum += kinematics::endpoint(ship->location, thrust, angle_deg).pos_x;
+                        }
+                    }
+                }
+                bench::sink += (long) sum;
+            }
+        } });
+
+        // Fight-or-flee input for every ship of player 0, as MyBot computes it each turn.
+        benchmarks.push_back({ "threat_field" + suffix, (long) fixture.map.ships.at(0).size(), [f](const long n) {
+            const EntityStore entities(f->map);
+            ThreatField threats;
+            for (long i = 0; i < n; ++i) {
+                threats.compute(entities, 0, constants::WEAPON_RADIUS + constants::MAX_SPEED);
+                bench::sink += threats[0].enemies;
+            }
+        } });
+
+        // Every undocked ship of player 0 is given a docking spot, from scratch as on the first turn...
+        benchmarks.push_back({ "planet_assignment_cold" + suffix, num_ships, [f](const long n) {
+            for (long i = 0; i < n; ++i) {
+                PlanetAssignment assignment;
+                assignment.solve(f->map, 0, f->undocked);
+                bench::sink += (long) assignment.bids();
+            }
+        } });
+
+        // ...and starting from the last turn's prices, as on every turn after.
+        benchmarks.push_back({ "planet_assignment_warm" + suffix, num_ships, [f](const long n) {
+            PlanetAssignment assignment;
+            assignment.solve(f->map, 0, f->undocked);
+            for (long i = 0; i < n; ++i) {
+                assignment.solve(f->map, 0, f->undocked);
+                bench::sink += (long) assignment.bids();
+            }
+        } });
+
+        // The pre-game work of routing around planets.
+        benchmarks.push_back({ "route_graph_build" + suffix, (long) fixture.map.planets.size(), [f](const long n) {
+            VisibilityGraph graph;
+            for (long i = 0; i < n; ++i) {
+                graph.build(f->map);
+                bench::sink += (long) graph.num_edges();
+            }
+        } });
+
+        // Every undocked ship of player 0 asks for the first corner on its way to a planet.
+        benchmarks.push_back({ "route_first_waypoint" + suffix, num_ships, [f](const long n) {
+            const VisibilityGraph graph(f->map);
+            for (long i = 0; i < n; ++i) {
+                double sum = 0;
+                for (size_t s = 0; s < f->undocked.size(); ++s) {
+                    const Location& start = f->undocked[s]->location;
+                    const Location target = start.get_closest_point(f->targets[s]->location, f->targets[s]->radius);
+                    sum += graph.first_waypoint(start, target).pos_x;
+                }
+                bench::sink += (long) sum;
+            }
+        } });
+
+        // The pre-game work of flow fields: one fast marching pass per planet.
+        benchmarks.push_back({ "flow_fields_build" + suffix, (long) fixture.map.planets.size(), [f](const long n) {
+            for (long i = 0; i < n; ++i) {
+                const FlowFields fields(f->map);
+                bench::sink += (long) fields.planet(f->map.planets[0].entity_id)->distance(f->undocked[0]->location);
+            }
+        } });
+
+        // The threat layer following every undocked enemy as it moves a step, and back.
+        benchmarks.push_back({ "flow_threat_update" + suffix, 1, [f](const long n) {
+            FlowFields fields = f->flow_fields();
+            Map moved = f->map;
+            for (auto& player_ships : moved.ships) {
+                for (Ship& ship : player_ships.second) {
+                    ship.location.pos_x += 1;
+                }
+            }
+            for (long i = 0; i < n; ++i) {
+                fields.begin_turn(i % 2 == 0 ? moved : f->map, 0);
+                bench::sink += (long) fields.threat_at(f->undocked[0]->location);
+            }
+        } });
+
+        // Every undocked ship of player 0 looks up its heading towards a planet.
+        benchmarks.push_back({ "flow_aim" + suffix, num_ships, [f](const long n) {
+            FlowFields fields = f->flow_fields();
+            fields.begin_turn(f->map, 0);
+            for (long i = 0; i < n; ++i) {
+                double sum = 0;
+                for (size_t s = 0; s < f->undocked.size(); ++s) {
+                    const FlowField& field = *fields.planet(f->targets[s]->entity_id);
+                    sum += fields.aim(field, f->undocked[s]->location, constants::MAX_SPEED).first.pos_x;
+                }
+                bench::sink += (long) sum;
+            }
+        } });
+
+        // A field built during the turn, around the enemies, towards an enemy ship.
+        benchmarks.push_back({ "flow_toward" + suffix, 1, [f](const long n) {
+            FlowFields fields = f->flow_fields();
+            const Location& goal = f->map.ships.at(1).front().location;
+            for (long i = 0; i < n; ++i) {
+                fields.begin_turn(f->map, 0);
+                bench::sink += (long) fields.toward(goal, constants::WEAPON_RADIUS).distance(f->undocked[0]->location);
+            }
+        } });
+
+        benchmarks.push_back({ "encode_moves" + suffix, num_ships, [f](const long n) {
+            out::MoveEncoder encoder;
+            for (long i = 0; i < n; ++i) {
+                encoder.encode(f->moves);
+                bench::sink += (long) encoder.size();
+            }
+        } });
+
+        // Taking a snapshot to roll out from, into storage kept from the last one.
+        benchmarks.push_back({ "forward_snapshot" + suffix, (long) fixture.state.ships.size(), [f](const long n) {
+            ForwardState copy;
+            for (long i = 0; i < n; ++i) {
+                copy = f->state;
+                bench::sink += (long) copy.ships.size();
+            }
+        } });
+
+        // One turn of a rollout: restore the snapshot, then every player's ships move, fight and dock.
+        benchmarks.push_back({ "forward_step" + suffix, (long) fixture.state.ships.size(), [f](const long n) {
+            ForwardModel model;
+            ForwardState copy;
+            for (long i = 0; i < n; ++i) {
+                copy = f->state;
+                model.step(copy, f->all_moves);
+                bench::sink += (long) copy.ships.size();
+            }
+        } });
+
+        return benchmarks;
+    }
+
+    double cpu_ns() {
+        return (double) std::clock() * 1e9 / CLOCKS_PER_SEC;
+    }
+
+    /**
+     * Grow the iteration count until a run takes at least min_time, then keep
+     * the fastest of repetitions runs of that many iterations.
+     */
+    Result measure(const Benchmark& benchmark, const double min_time_s, const int repetitions) {
+        long iterations = 1;
+        for (;;) {
+            const bench::Stopwatch timer;
+            benchmark.body(iterations);
+            const double elapsed_s = timer.elapsed_ms() / 1000;
+            if (elapsed_s >= min_time_s || iterations >= 1000000000L) {
+                break;
+            }
+            // Aim a little past min_time so the next run is usually the last.
+            const double scale = elapsed_s > 0 ? 1.4 * min_time_s / elapsed_s : 10.0;
+            iterations = (long) std::min((double) iterations * std::min(std::max(scale, 2.0), 10.0), 1e9);
+        }
+
+        Result result = { benchmark.name, iterations, 0, 0, benchmark.items };
+        for (int repetition = 0; repetition < repetitions; ++repetition) {
+            const double cpu_started = cpu_ns();
+            const bench::Stopwatch timer;
+            benchmark.body(iterations);
+            const double real = timer.elapsed_ms() * 1e6 / iterations;
+            const double cpu = (cpu_ns() - cpu_started) / iterations;
+            if (repetition == 0 || real < result.real_ns) {
+                result.real_ns = real;
+                result.cpu_ns = cpu;
+            }
+        }
+        return result;
+    }
+
+    std::string json_string(const std::string& text) {
+        std::string quoted = "\"";
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                quoted += '\\';
+            }
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    /// Results in the layout of Google Benchmark's --benchmark_format=json, so its tools can compare runs.
+    bool write_json(const std::string& filename, const std::vector<Result>& results, const int repetitions) {
+        std::FILE* file = std::fopen(filename.c_str(), "w");
+        if (file == nullptr) {
+            return false;
+        }
+        char date[64];
+        const std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+        std::fprintf(file, "{\n  \"context\": {\n");
+        std::fprintf(file, "    \"date\": %s,\n", json_string(date).c_str());
+        std::fprintf(file, "    \"executable\": \"hlt_bench\",\n");
+        std::fprintf(file, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+        std::fprintf(file, "    \"collision_batch_width\": %d\n  },\n", (int) collision::BATCH_WIDTH);
+        std::fprintf(file, "  \"benchmarks\": [\n");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& result = results[i];
+            std::fprintf(file, "    {\n");
+            std::fprintf(file, "      \"name\": %s,\n", json_string(result.name).c_str());
+            std::fprintf(file, "      \"run_name\": %s,\n", json_string(result.name).c_str());
+            std::fprintf(file, "      \"run_type\": \"iteration\",\n");
+            std::fprintf(file, "      \"repetitions\": %d,\n", repetitions);
+            std::fprintf(file, "      \"iterations\": %ld,\n", result.iterations);
+            std::fprintf(file, "      \"real_time\": %.3f,\n", result.real_ns);
+            std::fprintf(file, "      \"cpu_time\": %.3f,\n", result.cpu_ns);
+            std::fprintf(file, "      \"time_unit\": \"ns\",\n");
+            std::fprintf(file, "      \"items_per_second\": %.1f\n", result.items * 1e9 / result.real_ns);
+            std::fprintf(file, "    }%s\n", i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(file, "  ]\n}\n");
+        std::fclose(file);
+        return true;
+    }
+
+    void usage() {
+        std::fprintf(stderr,
+                     "usage: hlt_bench [--filter REGEX] [--min_time SECONDS] [--repetitions N] [--json FILE] [--list]\n"
+                     "  --filter       run only benchmarks whose name matches, e.g. 'parse|late'\n"
+                     "  --min_time     least time per measured run, default 0.1\n"
+                     "  --repetitions  measured runs per benchmark, the fastest is kept, default 3\n"
+                     "  --json         also write the results as JSON, for tracking them over time\n"
+                     "  --list         print the benchmark names and exit\n");
+    }
+}
+
+/**
+ * Microbenchmarks of the hlt library on reproducible synthetic maps, from
+ * an early-game map to a 4-player late game with 1200 ships. Single
+ * threaded, so numbers compare across machines with different core counts.
+ */
+int main(int argc, char** argv) {
+    std::string filter = ".*";
+    double min_time_s = 0.1;
+    int repetitions = 3;
+    std::string json_file;
+    bool list = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--min_time" && i + 1 < argc) {
+            min_time_s = std::atof(argv[++i]);
+        } else if (arg == "--repetitions" && i + 1 < argc) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_file = argv[++i];
+        } else if (arg == "--list") {
+            list = true;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    std::regex pattern;
+    try {
+        pattern = std::regex(filter);
+    } catch (const std::regex_error&) {
+        std::fprintf(stderr, "bad --filter: %s\n", filter.c_str());
+        return 1;
+    }
+
+    const Fixture fixtures[] = {
+            { "early_2p", { 240, 160, 2, 3, 12, 10 } },
+            { "mid_2p_500", { 240, 160, 2, 250, 20, 20 } },
+            { "late_4p_1200", { 384, 256, 4, 300, 28, 30 } },
+    };
+
+    std::vector<Benchmark> benchmarks;
+    for (const Fixture& fixture : fixtures) {
+        for (Benchmark& benchmark : make_benchmarks(fixture)) {
+            if (std::regex_search(benchmark.name, pattern)) {
+                benchmarks.push_back(benchmark);
+            }
+        }
+    }
+    if (list) {
+        for (const Benchmark& benchmark : benchmarks) {
+            std::printf("%s\n", benchmark.name.c_str());
+        }
+        return 0;
+    }
+
+    std::printf("%-40s %14s %14s %12s %14s\n", "Benchmark", "Time", "CPU", "Iterations", "items/s");
+    std::vector<Result> results;
+    for (const Benchmark& benchmark : benchmarks) {
+        results.push_back(measure(benchmark, min_time_s, repetitions));
+        const Result& result = results.back();
+        std::printf("%-40s %11.0f ns %11.0f ns %12ld %13.3gM\n", result.name.c_str(), result.real_ns, result.cpu_ns,
+                    result.iterations, result.items * 1e3 / result.real_ns);
+        std::fflush(stdout);
+    }
+
+    if (!json_file.empty() && !write_json(json_file, results, repetitions)) {
+        std::fprintf(stderr, "cannot write %s\n", json_file.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace hlt {
+    /**
+     * Bump allocator for short-lived scratch: allocating moves a pointer
+     * forward, freeing does nothing, and reset() drops everything at once,
+     * typically at the start of each turn.
+     *
+     * Memory comes in chunks. When a turn needed more than one, reset()
+     * replaces them by a single chunk as large as all of them together, so
+     * once the first busy turns have sized it the arena stops calling malloc.
+     *
+     * Not thread safe: allocate from the thread that owns the arena. Other
+     * threads may read and write memory that was handed out.
+     */
+    class Arena {
+    public:
+        static const size_t DEFAULT_CHUNK_BYTES = 64 * 1024;
+
+        explicit Arena(const size_t chunk_bytes = DEFAULT_CHUNK_BYTES) : chunk_bytes(chunk_bytes) {
+        }
+
+        /// Copies start out empty: what an arena holds only lives until its next reset.
+        Arena(const Arena& other) : Arena(other.chunk_bytes) {
+        }
+
+        Arena(Arena&&) = default;
+        Arena& operator=(const Arena&) = delete;
+        Arena& operator=(Arena&&) = default;
+
+        void* allocate(const size_t bytes, const size_t alignment) {
+            size_t start = align_up(offset, alignment);
+            if (chunks.empty() || start + bytes > chunks[current].size) {
+                add_chunk(bytes + alignment);
+                start = align_up(offset, alignment);
+            }
+            offset = start + bytes;
+            used += bytes;
+            return chunks[current].memory.get() + start;
+        }
+
+        /// Free everything allocated since the last reset.
+        void reset() {
+            peak = std::max(peak, used);
+            if (chunks.size() > 1) {
+                const size_t total = capacity();
+                chunks.clear();
+                chunks.push_back(make_chunk(total));
+            }
+            current = 0;
+            offset = 0;
+            used = 0;
+        }
+
+        /// Bytes handed out since the last reset.
+        size_t bytes_used() const {
+            return used;
+        }
+
+        /// The most bytes handed out between two resets so far.
+        size_t peak_bytes() const {
+            return std::max(peak, used);
+        }
+
+        /// Bytes held in chunks.
+        size_t capacity() const {
+            size_t total = 0;
+            for (const Chunk& chunk : chunks) {
+                total += chunk.size;
+            }
+            return total;
+        }
+
+        /// How many times the arena went to the heap for a chunk.
+        size_t chunk_allocations() const {
+            return num_chunk_allocations;
+        }
+
+    private:
+        struct Chunk {
+            std::unique_ptr<char[]> memory;
+            size_t size;
+        };
+
+        size_t chunk_bytes;
+        std::vector<Chunk> chunks;
+        size_t current = 0;
+        size_t offset = 0;
+        size_t used = 0;
+        size_t peak = 0;
+        size_t num_chunk_allocations = 0;
+
+        // Chunks come from new char[], which is aligned for any fundamental type.
+        static size_t align_up(const size_t value, const size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        Chunk make_chunk(const size_t size) {
+            ++num_chunk_allocations;
+            return { std::unique_ptr<char[]>(new char[size]), size };
+        }
+
+        /// Move on to a new chunk with room for at least min_size bytes; chunks double in size.
+        void add_chunk(const size_t min_size) {
+            const size_t size = std::max(std::max(min_size, chunk_bytes), capacity());
+            chunks.push_back(make_chunk(size));
+            current = chunks.size() - 1;
+            offset = 0;
+        }
+    };
+
+    /**
+     * Standard allocator over an Arena, or over the heap when it has none,
+     * so the same container type serves both.
+     *
+     * Copies of a container go to the heap, since they may well outlive
+     * the arena; moves and swaps carry the arena along.
+     */
+    template<typename T>
+    class ArenaAllocator {
+    public:
+        typedef T value_type;
+        typedef std::false_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        ArenaAllocator() noexcept : arena(nullptr) {
+        }
+
+        ArenaAllocator(Arena* arena) noexcept : arena(arena) {
+        }
+
+        template<typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {
+        }
+
+        T* allocate(const size_t count) {
+            if (arena == nullptr) {
+                return static_cast<T*>(::operator new(count * sizeof(T)));
+            }
+            return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* memory, size_t) noexcept {
+            if (arena == nullptr) {
+                ::operator delete(memory);
+            }
+        }
+
+        ArenaAllocator select_on_container_copy_construction() const {
+            return ArenaAllocator();
+        }
+
+        Arena* arena;
+    };
+
+    template<typename T, typename U>
+    bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+        return a.arena == b.arena;
+    }
+
+    template<typename T, typename U>
+    bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+        return a.arena != b.arena;
+    }
+
+    template<typename T>
+    using arena_vector = std::vector<T, ArenaAllocator<T>>;
+
+    template<typename K, typename V>
+    using arena_unordered_map = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
+                                                   ArenaAllocator<std::pair<const K, V>>>;
+}
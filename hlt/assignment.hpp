@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "constants.hpp"
+#include "map.hpp"
+
+namespace hlt {
+    /**
+     * Assigns ships to the free docking spots of the planets they may dock
+     * on, minimising the total number of turns until every assigned ship is
+     * docked, instead of letting each ship take the nearest planet and
+     * crowding planets with few spots.
+     *
+     * The cost of a ship for a planet is the turns to reach its docking
+     * range at MAX_SPEED plus DOCK_TURNS. A planet takes as many ships as it
+     * has free spots; ships left over, or with nothing worth the trip,
+     * stay unassigned.
+     *
+     * Solved with the auction algorithm (Bertsekas): unassigned ships bid
+     * for the spot that is best for them at the current prices, outbidding
+     * whoever held it, until every ship holds a spot or prefers none. Spot
+     * prices carry over from turn to turn, so after the first turn most
+     * ships settle with their first bid. A carried-over price on a spot
+     * nobody holds would keep ships away from it, so such spots then bid
+     * for ships in turn (a reverse auction) until each holds a ship or is
+     * back at zero. The result is within EPSILON turns per ship of the
+     * optimum.
+     *
+     * Keep one per bot: the buffers and prices live from turn to turn.
+     */
+    class PlanetAssignment {
+    public:
+        /// How much worse than optimal each ship's choice may be, in turns.
+        static constexpr double EPSILON = 0.01;
+
+        /**
+         * Assign ships, which should all be player_id's and undocked, to the
+         * free spots of the planets player_id owns or nobody does.
+         */
+        void solve(const Map& map, const PlayerId player_id, const std::vector<const Ship*>& ships) {
+            num_ships = ships.size();
+            setup_planets(map, player_id);
+            setup_costs(map, ships);
+
+            assigned.assign(num_ships, UNASSIGNED);
+            num_bids = 0;
+            queue.clear();
+            for (unsigned int i = 0; i < num_ships; ++i) {
+                queue.push_back(i);
+            }
+            run_auction();
+
+            // Carried-over prices may keep a spot nobody wants this turn above zero, which
+            // would keep ships away from it for no reason. Such spots bid for ships until
+            // every spot nobody holds is free again.
+            for (bool reopened = true; reopened; ) {
+                reopened = false;
+                for (size_t spot = 0; spot < spot_price.size(); ++spot) {
+                    if (spot_holder[spot] == UNASSIGNED && spot_price[spot] > 0) {
+                        reverse_bid(static_cast<unsigned int>(spot));
+                        reopened = true;
+                    }
+                }
+            }
+
+            remember_prices();
+        }
+
+        /// The planet ships[i] of the last solve() should dock on, or nullptr.
+        const Planet* planet_of(const size_t i) const {
+            return assigned[i] >= 0 ? planets[spot_planet[assigned[i]]] : nullptr;
+        }
+
+        /// Bids made by the last solve(), a measure of how contested the spots were.
+        size_t bids() const {
+            return num_bids;
+        }
+
+    private:
+        enum : int {
+            /// Waiting to bid.
+            UNASSIGNED = -1,
+            /// Better off without a spot.
+            NONE = -2,
+        };
+
+        size_t num_ships = 0;
+        size_t num_bids = 0;
+        /// What a ship gives up by staying unassigned, in turns: more than any trip across the map.
+        double none_cost = 0;
+
+        std::vector<const Planet*> planets;
+        /// The spots of planets[p] are [planet_spots[p], planet_spots[p + 1]).
+        std::vector<unsigned int> planet_spots;
+        std::vector<unsigned int> spot_planet;
+        std::vector<double> spot_price;
+        std::vector<int> spot_holder;
+
+        /// costs[i * planets.size() + p]: turns until ships[i] is docked on planets[p].
+        std::vector<double> costs;
+        /// Spot index, UNASSIGNED or NONE, per ship.
+        std::vector<int> assigned;
+        std::vector<unsigned int> queue;
+
+        /// Last turn's spot prices, by planet id: the prices of planet id are [warm_begin[id], warm_begin[id + 1]).
+        std::vector<unsigned int> warm_begin;
+        std::vector<double> warm_prices;
+
+        void setup_planets(const Map& map, const PlayerId player_id) {
+            planets.clear();
+            planet_spots.assign(1, 0);
+            spot_planet.clear();
+            spot_price.clear();
+            for (const Planet& planet : map.planets) {
+                if (planet.owned && planet.owner_id != player_id) {
+                    continue;
+                }
+                const size_t docked = planet.docked_ships.size();
+                const unsigned int free_spots = docked < planet.docking_spots
+                                                ? planet.docking_spots - static_cast<unsigned int>(docked) : 0;
+                if (free_spots == 0) {
+                    continue;
+                }
+                const unsigned int p = static_cast<unsigned int>(planets.size());
+                planets.push_back(&planet);
+
+                // Prices of the spots this planet had last turn, highest first; new spots start at zero.
+                const unsigned int id = static_cast<unsigned int>(planet.entity_id);
+                const bool warm = id + 1 < warm_begin.size();
+                for (unsigned int k = 0; k < free_spots; ++k) {
+                    spot_planet.push_back(p);
+                    const unsigned int warm_index = warm ? warm_begin[id] + k : 0;
+                    spot_price.push_back(warm && warm_index < warm_begin[id + 1] ? warm_prices[warm_index] : 0);
+                }
+                planet_spots.push_back(static_cast<unsigned int>(spot_planet.size()));
+            }
+            spot_holder.assign(spot_planet.size(), UNASSIGNED);
+        }
+
+        void setup_costs(const Map& map, const std::vector<const Ship*>& ships) {
+            none_cost = std::sqrt(static_cast<double>(map.map_width) * map.map_width
+                                  + static_cast<double>(map.map_height) * map.map_height) / constants::MAX_SPEED
+                        + constants::DOCK_TURNS + 1;
+            costs.resize(num_ships * planets.size());
+            for (size_t i = 0; i < num_ships; ++i) {
+                double* row = &costs[i * planets.size()];
+                for (size_t p = 0; p < planets.size(); ++p) {
+                    const Planet& planet = *planets[p];
+                    const double trip = ships[i]->location.get_distance_to(planet.location)
+                                        - planet.radius - constants::DOCK_RADIUS;
+                    row[p] = std::max(0.0, trip) / constants::MAX_SPEED + constants::DOCK_TURNS;
+                }
+            }
+        }
+
+        /// Gauss-Seidel auction: ships in the queue bid one at a time until the queue is empty.
+        void run_auction() {
+            size_t head = 0;
+            while (head < queue.size()) {
+                const unsigned int i = queue[head++];
+                // Compact the queue now and then rather than letting it grow with every outbid ship.
+                if (head > 1024 && head * 2 > queue.size()) {
+                    queue.erase(queue.begin(), queue.begin() + head);
+                    head = 0;
+                }
+
+                double best, second;
+                const int best_spot = best_two(i, best, second);
+                assigned[i] = best_spot;
+                if (best_spot == NONE) {
+                    continue;
+                }
+                ++num_bids;
+                spot_price[best_spot] += best - second + EPSILON;
+                const int outbid = spot_holder[best_spot];
+                spot_holder[best_spot] = static_cast<int>(i);
+                if (outbid >= 0) {
+                    assigned[outbid] = UNASSIGNED;
+                    queue.push_back(static_cast<unsigned int>(outbid));
+                }
+            }
+            queue.clear();
+        }
+
+        /// The best spot for ship i at the current prices, or NONE; best and second best value (minus cost and price).
+        int best_two(const unsigned int i, double& best, double& second) const {
+            const double* row = &costs[i * planets.size()];
+            best = -none_cost;
+            second = -none_cost;
+            int best_spot = NONE;
+            for (size_t p = 0; p < planets.size(); ++p) {
+                for (unsigned int spot = planet_spots[p]; spot < planet_spots[p + 1]; ++spot) {
+                    const double value = -row[p] - spot_price[spot];
+                    if (value > best) {
+                        second = best;
+                        best = value;
+                        best_spot = static_cast<int>(spot);
+                    } else if (value > second) {
+                        second = value;
+                    }
+                }
+            }
+            return best_spot;
+        }
+
+        /// What ship i gets out of its current choice: minus cost and price of its spot, or minus none_cost.
+        double profit(const unsigned int i) const {
+            const int spot = assigned[i];
+            return spot >= 0 ? -costs[i * planets.size() + spot_planet[spot]] - spot_price[spot] : -none_cost;
+        }
+
+        /**
+         * Reverse auction step for a spot nobody holds (Bertsekas): take the
+         * ship that gains most by moving to it, if that is at least EPSILON,
+         * and price the spot just low enough to beat the runner-up; otherwise
+         * drop its price to zero. The ship's own spot is left unheld, but its
+         * profit rises by EPSILON or more, so the steps come to an end, and
+         * every ship stays within EPSILON of its best choice.
+         */
+        void reverse_bid(const unsigned int spot) {
+            const size_t p = spot_planet[spot];
+            double best = -HUGE_VAL;
+            double second = -HUGE_VAL;
+            int best_ship = -1;
+            for (unsigned int i = 0; i < num_ships; ++i) {
+                const double gain = -costs[i * planets.size() + p] - profit(i);
+                if (gain > best) {
+                    second = best;
+                    best = gain;
+                    best_ship = static_cast<int>(i);
+                } else if (gain > second) {
+                    second = gain;
+                }
+            }
+
+            if (best_ship < 0 || best < EPSILON) {
+                spot_price[spot] = 0;
+                return;
+            }
+            ++num_bids;
+            spot_price[spot] = std::max(0.0, second - EPSILON);
+            const int left = assigned[best_ship];
+            if (left >= 0) {
+                spot_holder[left] = UNASSIGNED;
+            }
+            assigned[best_ship] = static_cast<int>(spot);
+            spot_holder[spot] = best_ship;
+        }
+
+        void remember_prices() {
+            EntityId max_id = 0;
+            for (const Planet* planet : planets) {
+                max_id = std::max(max_id, planet->entity_id);
+            }
+            warm_begin.assign(planets.empty() ? 0 : static_cast<size_t>(max_id) + 2, 0);
+            for (size_t p = 0; p < planets.size(); ++p) {
+                warm_begin[planets[p]->entity_id + 1] = planet_spots[p + 1] - planet_spots[p];
+            }
+            for (size_t id = 1; id < warm_begin.size(); ++id) {
+                warm_begin[id] += warm_begin[id - 1];
+            }
+
+            // Highest first, so a planet that loses free spots keeps the prices of the contested ones.
+            warm_prices.resize(spot_price.size());
+            for (size_t p = 0; p < planets.size(); ++p) {
+                const auto begin = spot_price.begin() + planet_spots[p];
+                const auto end = spot_price.begin() + planet_spots[p + 1];
+                std::sort(begin, end, [](const double a, const double b) {
+                    return a > b;
+                });
+                std::copy(begin, end, warm_prices.begin() + warm_begin[planets[p]->entity_id]);
+            }
+        }
+    };
+}
@@ -1,9 +1,19 @@
 #pragma once
 
 #include <algorithm>
+#include <cstddef>
+
+#if !defined(HLT_NO_SIMD) && defined(__AVX__)
+#define HLT_COLLISION_AVX 1
+#include <immintrin.h>
+#elif !defined(HLT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#define HLT_COLLISION_SSE2 1
+#include <emmintrin.h>
+#endif
 
 #include "entity.hpp"
 #include "location.hpp"
+#include "profile.hpp"
 
 namespace hlt {
     namespace collision {
@@ -14,28 +24,31 @@ namespace hlt {
         /**
          * Test whether a given line segment intersects a circular area.
          *
-         * @param start  The start of the segment.
-         * @param end    The end of the segment.
-         * @param circle The circle to test against.
-         * @param fudge  An additional safety zone to leave when looking for collisions. Probably set it to ship radius.
+         * @param start         The start of the segment.
+         * @param end           The end of the segment.
+         * @param center        The center of the circle to test against.
+         * @param circle_radius The radius of the circle to test against.
+         * @param fudge         An additional safety zone to leave when looking for collisions. Probably set it to ship radius.
          * @return true if the segment intersects, false otherwise
          */
         static bool segment_circle_intersect(
                 const Location& start,
                 const Location& end,
-                const Entity& circle,
+                const Location& center,
+                const double circle_radius,
                 const double fudge)
         {
+            HLT_PROFILE_COUNT(SegmentCircleTests, 1);
+
             // Parameterize the segment as start + t * (end - start),
             // and substitute into the equation of a circle
             // Solve for t
-            const double circle_radius = circle.radius;
             const double start_x = start.pos_x;
             const double start_y = start.pos_y;
             const double end_x = end.pos_x;
             const double end_y = end.pos_y;
-            const double center_x = circle.location.pos_x;
-            const double center_y = circle.location.pos_y;
+            const double center_x = center.pos_x;
+            const double center_y = center.pos_y;
             const double dx = end_x - start_x;
             const double dy = end_y - start_y;
 
@@ -49,7 +62,7 @@ namespace hlt {
 
             if (a == 0.0) {
                 // Start and end are the same point
-                return start.get_distance_to(circle.location) <= circle_radius + fudge;
+                return start.get_distance_to(center) <= circle_radius + fudge;
             }
 
             // Time along segment when closest to the circle (vertex of the quadratic)
@@ -60,9 +73,228 @@ namespace hlt {
 
             const double closest_x = start_x + dx * t;
             const double closest_y = start_y + dy * t;
-            const double closest_distance = Location{ closest_x, closest_y }.get_distance_to(circle.location);
+            const double closest_distance = Location{ closest_x, closest_y }.get_distance_to(center);
 
             return closest_distance <= circle_radius + fudge;
         }
+
+        /**
+         * Test whether a given line segment intersects a circular area.
+         *
+         * @param start  The start of the segment.
+         * @param end    The end of the segment.
+         * @param circle The circle to test against.
+         * @param fudge  An additional safety zone to leave when looking for collisions. Probably set it to ship radius.
+         * @return true if the segment intersects, false otherwise
+         */
+        static bool segment_circle_intersect(
+                const Location& start,
+                const Location& end,
+                const Entity& circle,
+                const double fudge)
+        {
+            return segment_circle_intersect(start, end, circle.location, circle.radius, fudge);
+        }
+
+        /**
+         * Terms of segment_circle_intersect that depend only on the segment,
+         * kept so the batched kernels below evaluate the exact same sequence
+         * of operations per circle and round identically.
+         */
+        struct SegmentTerms {
+            double start_x, start_y, dx, dy, a, two_a;
+            double b_head;      // square(start_x) - (start_x * end_x)
+            double end_x, square_start_y, start_y_end_y, end_y;
+
+            SegmentTerms(const Location& start, const Location& end) :
+                    start_x(start.pos_x), start_y(start.pos_y),
+                    dx(end.pos_x - start.pos_x), dy(end.pos_y - start.pos_y),
+                    a(square(dx) + square(dy)), two_a(2 * a),
+                    b_head(square(start.pos_x) - (start.pos_x * end.pos_x)),
+                    end_x(end.pos_x), square_start_y(square(start.pos_y)),
+                    start_y_end_y(start.pos_y * end.pos_y), end_y(end.pos_y)
+            {
+            }
+        };
+
+#if defined(HLT_COLLISION_AVX)
+        static const size_t BATCH_WIDTH = 4;
+
+        /// Bit i of the result is set if circle (first + i) intersects.
+        static int segment_circle_lanes(
+                const SegmentTerms& seg,
+                const double* center_x,
+                const double* center_y,
+                const double* radius,
+                const double fudge)
+        {
+            HLT_PROFILE_COUNT(SegmentCircleTests, BATCH_WIDTH);
+
+            const __m256d cx = _mm256_loadu_pd(center_x);
+            const __m256d cy = _mm256_loadu_pd(center_y);
+            const __m256d limit = _mm256_add_pd(_mm256_loadu_pd(radius), _mm256_set1_pd(fudge));
+            const __m256d sx = _mm256_set1_pd(seg.start_x);
+            const __m256d sy = _mm256_set1_pd(seg.start_y);
+
+            __m256d ddx, ddy, in_front;
+            if (seg.a == 0.0) {
+                ddx = _mm256_sub_pd(sx, cx);
+                ddy = _mm256_sub_pd(sy, cy);
+                in_front = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+            } else {
+                __m256d sum = _mm256_sub_pd(_mm256_set1_pd(seg.b_head), _mm256_mul_pd(sx, cx));
+                sum = _mm256_add_pd(sum, _mm256_mul_pd(_mm256_set1_pd(seg.end_x), cx));
+                sum = _mm256_add_pd(sum, _mm256_set1_pd(seg.square_start_y));
+                sum = _mm256_sub_pd(sum, _mm256_set1_pd(seg.start_y_end_y));
+                sum = _mm256_sub_pd(sum, _mm256_mul_pd(sy, cy));
+                sum = _mm256_add_pd(sum, _mm256_mul_pd(_mm256_set1_pd(seg.end_y), cy));
+                const __m256d b = _mm256_mul_pd(_mm256_set1_pd(-2.0), sum);
+                const __m256d neg_b = _mm256_xor_pd(b, _mm256_set1_pd(-0.0));
+
+                // std::min(x, 1.0) == (1.0 < x ? 1.0 : x) == minpd(1.0, x)
+                const __m256d t = _mm256_min_pd(_mm256_set1_pd(1.0), _mm256_div_pd(neg_b, _mm256_set1_pd(seg.two_a)));
+                in_front = _mm256_cmp_pd(t, _mm256_setzero_pd(), _CMP_GE_OQ);
+
+                ddx = _mm256_sub_pd(_mm256_add_pd(sx, _mm256_mul_pd(_mm256_set1_pd(seg.dx), t)), cx);
+                ddy = _mm256_sub_pd(_mm256_add_pd(sy, _mm256_mul_pd(_mm256_set1_pd(seg.dy), t)), cy);
+            }
+
+            const __m256d distance = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(ddx, ddx), _mm256_mul_pd(ddy, ddy)));
+            const __m256d hit = _mm256_and_pd(in_front, _mm256_cmp_pd(distance, limit, _CMP_LE_OQ));
+            return _mm256_movemask_pd(hit);
+        }
+#elif defined(HLT_COLLISION_SSE2)
+        static const size_t BATCH_WIDTH = 2;
+
+        /// Bit i of the result is set if circle (first + i) intersects.
+        static int segment_circle_lanes(
+                const SegmentTerms& seg,
+                const double* center_x,
+                const double* center_y,
+                const double* radius,
+                const double fudge)
+        {
+            HLT_PROFILE_COUNT(SegmentCircleTests, BATCH_WIDTH);
+
+            const __m128d cx = _mm_loadu_pd(center_x);
+            const __m128d cy = _mm_loadu_pd(center_y);
+            const __m128d limit = _mm_add_pd(_mm_loadu_pd(radius), _mm_set1_pd(fudge));
+            const __m128d sx = _mm_set1_pd(seg.start_x);
+            const __m128d sy = _mm_set1_pd(seg.start_y);
+
+            __m128d ddx, ddy, in_front;
+            if (seg.a == 0.0) {
+                ddx = _mm_sub_pd(sx, cx);
+                ddy = _mm_sub_pd(sy, cy);
+                in_front = _mm_castsi128_pd(_mm_set1_epi32(-1));
+            } else {
+                __m128d sum = _mm_sub_pd(_mm_set1_pd(seg.b_head), _mm_mul_pd(sx, cx));
+                sum = _mm_add_pd(sum, _mm_mul_pd(_mm_set1_pd(seg.end_x), cx));
+                sum = _mm_add_pd(sum, _mm_set1_pd(seg.square_start_y));
+                sum = _mm_sub_pd(sum, _mm_set1_pd(seg.start_y_end_y));
+                sum = _mm_sub_pd(sum, _mm_mul_pd(sy, cy));
+                sum = _mm_add_pd(sum, _mm_mul_pd(_mm_set1_pd(seg.end_y), cy));
+                const __m128d b = _mm_mul_pd(_mm_set1_pd(-2.0), sum);
+                const __m128d neg_b = _mm_xor_pd(b, _mm_set1_pd(-0.0));
+
+                // std::min(x, 1.0) == (1.0 < x ? 1.0 : x) == minpd(1.0, x)
+                const __m128d t = _mm_min_pd(_mm_set1_pd(1.0), _mm_div_pd(neg_b, _mm_set1_pd(seg.two_a)));
+                in_front = _mm_cmpge_pd(t, _mm_setzero_pd());
+
+                ddx = _mm_sub_pd(_mm_add_pd(sx, _mm_mul_pd(_mm_set1_pd(seg.dx), t)), cx);
+                ddy = _mm_sub_pd(_mm_add_pd(sy, _mm_mul_pd(_mm_set1_pd(seg.dy), t)), cy);
+            }
+
+            const __m128d distance = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(ddx, ddx), _mm_mul_pd(ddy, ddy)));
+            const __m128d hit = _mm_and_pd(in_front, _mm_cmple_pd(distance, limit));
+            return _mm_movemask_pd(hit);
+        }
+#else
+        static const size_t BATCH_WIDTH = 1;
+
+        /// Bit 0 of the result is set if the circle intersects.
+        static int segment_circle_lanes(
+                const SegmentTerms& seg,
+                const double* center_x,
+                const double* center_y,
+                const double* radius,
+                const double fudge)
+        {
+            const Location start = { seg.start_x, seg.start_y };
+            const Location end = { seg.end_x, seg.end_y };
+            return segment_circle_intersect(start, end, { *center_x, *center_y }, *radius, fudge) ? 1 : 0;
+        }
+#endif
+
+        /**
+         * Test one segment against circles stored as separate x, y and radius
+         * arrays. Agrees exactly with segment_circle_intersect for every circle.
+         *
+         * @param first Index to start testing from.
+         * @return Index of the first intersecting circle at or after first, or count if none.
+         */
+        static size_t segment_circles_first_hit(
+                const Location& start,
+                const Location& end,
+                const double* center_x,
+                const double* center_y,
+                const double* radius,
+                const size_t count,
+                const double fudge,
+                size_t first = 0)
+        {
+            const SegmentTerms seg(start, end);
+
+            for (; first + BATCH_WIDTH <= count; first += BATCH_WIDTH) {
+                const int mask = segment_circle_lanes(seg, center_x + first, center_y + first, radius + first, fudge);
+                if (mask != 0) {
+                    size_t lane = 0;
+                    while (!(mask & (1 << lane))) {
+                        ++lane;
+                    }
+                    return first + lane;
+                }
+            }
+            for (; first < count; ++first) {
+                if (segment_circle_intersect(start, end, { center_x[first], center_y[first] }, radius[first], fudge)) {
+                    return first;
+                }
+            }
+            return count;
+        }
+
+        /**
+         * Test one segment against circles stored as separate x, y and radius
+         * arrays, writing 1 to hits[i] if circle i intersects and 0 otherwise.
+         *
+         * @return The number of intersecting circles.
+         */
+        static size_t segment_circles_hit_mask(
+                const Location& start,
+                const Location& end,
+                const double* center_x,
+                const double* center_y,
+                const double* radius,
+                const size_t count,
+                const double fudge,
+                unsigned char* hits)
+        {
+            const SegmentTerms seg(start, end);
+            size_t num_hits = 0;
+
+            size_t i = 0;
+            for (; i + BATCH_WIDTH <= count; i += BATCH_WIDTH) {
+                const int mask = segment_circle_lanes(seg, center_x + i, center_y + i, radius + i, fudge);
+                for (size_t lane = 0; lane < BATCH_WIDTH; ++lane) {
+                    hits[i + lane] = static_cast<unsigned char>((mask >> lane) & 1);
+                    num_hits += hits[i + lane];
+                }
+            }
+            for (; i < count; ++i) {
+                hits[i] = segment_circle_intersect(start, end, { center_x[i], center_y[i] }, radius[i], fudge) ? 1 : 0;
+                num_hits += hits[i];
+            }
+            return num_hits;
+        }
     }
 }
@@ -44,12 +44,43 @@ namespace hlt {
         /** Distance from the planets edge at which new ships are created */
         constexpr int SPAWN_RADIUS = 2;
 
+        /** Production a planet accumulates to create one ship */
+        constexpr int PRODUCTION_PER_SHIP = 72;
+
+        /** Time a bot has to answer the engine each turn, in milliseconds */
+        constexpr int TURN_TIME_LIMIT_MS = 2000;
+
+        /** Time a bot has from receiving the initial map until sending its name, in milliseconds */
+        constexpr int PREGAME_TIME_LIMIT_MS = 60000;
+
         ////////////////////////////////////////////////////////////////////////
         // Implementation-specific constants
 
         constexpr double FORECAST_FUDGE_FACTOR = SHIP_RADIUS + 0.1;
         constexpr int MAX_NAVIGATION_CORRECTIONS = 90;
 
+        /** Fallback targets a MovePlanner request may hold; the rest are dropped */
+        constexpr int MAX_PLANNED_TARGETS = 8;
+
+        /**
+         * Edge length of a cell in the navigation SpatialIndex. One turn of
+         * travel plus the safety margin, so a single move touches few cells.
+         */
+        constexpr double SPATIAL_INDEX_CELL_SIZE = MAX_SPEED + FORECAST_FUDGE_FACTOR;
+
+        /** Spacing of the grid points of FlowFields, in map units */
+        constexpr double FLOW_FIELD_CELL_SIZE = 2.0;
+
+        /**
+         * Part of the turn limit held back for sending moves and for
+         * scheduling jitter on the game server. The turn budget counts
+         * as exhausted once only this much time is left.
+         */
+        constexpr int TURN_TIME_RESERVE_MS = 300;
+
+        /** Remaining turn budget below which navigation drops to its cheap mode */
+        constexpr int TURN_TIME_LOW_MS = 400;
+
         /**
          * Used in Location::get_closest_point()
          * Minimum distance specified from the object's outer radius.
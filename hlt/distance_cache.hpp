@@ -0,0 +1,266 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include "arena.hpp"
+#include "map.hpp"
+
+namespace hlt {
+    /**
+     * Per-turn distances from one player's ships to every planet and every
+     * enemy ship, so strategy code can walk targets nearest-first without
+     * sorting (or mutating) map.planets for each ship.
+     *
+     * Squared distances are filled in lazily, one row per ship, into flat
+     * tables; the nearest-first orderings are also built on first use and
+     * then kept for the rest of the turn. Pointers refer into the Map the
+     * cache was built from, which must outlive it.
+     *
+     * All tables are allocated up front, from arena if one is given, so
+     * queries never allocate. Each ship only touches its own rows, so
+     * different ships may be queried from different threads at the same time.
+     */
+    class DistanceCache {
+    public:
+        /**
+         * Targets in order of distance from one ship: a view into the cache.
+         * It stays valid until the same ship is ranked again against the
+         * same kind of target.
+         */
+        template<typename T>
+        class Ranking {
+        public:
+            class iterator {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef const T* value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const T* const* pointer;
+                typedef const T* reference;
+
+                iterator(const T* const* targets, const unsigned int* order) : targets(targets), order(order) {
+                }
+
+                const T* operator*() const {
+                    return targets[*order];
+                }
+
+                iterator& operator++() {
+                    ++order;
+                    return *this;
+                }
+
+                bool operator==(const iterator& other) const {
+                    return order == other.order;
+                }
+
+                bool operator!=(const iterator& other) const {
+                    return order != other.order;
+                }
+
+            private:
+                const T* const* targets;
+                const unsigned int* order;
+            };
+
+            Ranking(const T* const* targets, const unsigned int* order, const size_t count) :
+                    targets(targets), order(order), count(count)
+            {
+            }
+
+            iterator begin() const {
+                return iterator(targets, order);
+            }
+
+            iterator end() const {
+                return iterator(targets, order + count);
+            }
+
+            size_t size() const {
+                return count;
+            }
+
+            bool empty() const {
+                return count == 0;
+            }
+
+            const T* operator[](const size_t i) const {
+                return targets[order[i]];
+            }
+
+        private:
+            const T* const* targets;
+            const unsigned int* order;
+            size_t count;
+        };
+
+        DistanceCache(const Map& map, const PlayerId player_id, Arena* arena = nullptr) :
+                player_id(player_id),
+                planets(arena), enemies(arena), row_by_id(arena),
+                planet_distances(arena), enemy_distances(arena),
+                planet_row_ready(arena), enemy_row_ready(arena),
+                planet_order(arena), enemy_order(arena),
+                planet_sorted(arena), enemy_sorted(arena)
+        {
+            // Count first, so that every table is allocated once at its final size.
+            size_t num_enemies = 0;
+            EntityId max_id = 0;
+            for (const auto& player_ships : map.ships) {
+                if (player_ships.first != player_id) {
+                    num_enemies += player_ships.second.size();
+                    continue;
+                }
+                num_rows = static_cast<int>(player_ships.second.size());
+                for (const Ship& ship : player_ships.second) {
+                    max_id = std::max(max_id, ship.entity_id);
+                }
+            }
+
+            planets.reserve(map.planets.size());
+            for (const Planet& planet : map.planets) {
+                planets.push_back(&planet);
+            }
+            enemies.reserve(num_enemies);
+            row_by_id.assign(num_rows > 0 ? max_id + 1 : 0, -1);
+            int row = 0;
+            for (const auto& player_ships : map.ships) {
+                if (player_ships.first == player_id) {
+                    for (const Ship& ship : player_ships.second) {
+                        row_by_id[ship.entity_id] = row++;
+                    }
+                } else {
+                    for (const Ship& ship : player_ships.second) {
+                        enemies.push_back(&ship);
+                        num_docked_enemies += ship.docking_status != ShipDockingStatus::Undocked;
+                    }
+                }
+            }
+
+            const size_t rows = static_cast<size_t>(num_rows);
+            planet_distances.resize(rows * planets.size());
+            enemy_distances.resize(rows * enemies.size());
+            planet_row_ready.assign(rows, false);
+            enemy_row_ready.assign(rows, false);
+            planet_order.resize(rows * planets.size());
+            enemy_order.resize(rows * enemies.size());
+            planet_sorted.assign(rows, 0);
+            enemy_sorted.assign(rows, 0);
+        }
+
+        /// Squared distance between the centers of one of our ships and a planet (index into map.planets).
+        double squared_distance_to_planet(const Ship& ship, const size_t planet_index) {
+            return planet_row(ship)[planet_index];
+        }
+
+        /// All planets, nearest first.
+        Ranking<Planet> planets_by_distance(const Ship& ship) {
+            return nearest_planets(ship, planets.size());
+        }
+
+        /// All ships of other players, nearest first.
+        Ranking<Ship> enemies_by_distance(const Ship& ship) {
+            return nearest_enemies(ship, enemies.size());
+        }
+
+        /// The k nearest planets, nearest first.
+        Ranking<Planet> nearest_planets(const Ship& ship, const size_t k) {
+            const size_t row = static_cast<size_t>(row_of(ship));
+            return ranked(planets, planet_row(ship), planet_order.data() + row * planets.size(), planet_sorted[row], k);
+        }
+
+        /// The k nearest enemy ships, nearest first.
+        Ranking<Ship> nearest_enemies(const Ship& ship, const size_t k) {
+            const size_t row = static_cast<size_t>(row_of(ship));
+            return ranked(enemies, enemy_row(ship), enemy_order.data() + row * enemies.size(), enemy_sorted[row], k);
+        }
+
+        /// Whether any enemy ship is docked, docking or undocking.
+        bool has_docked_enemies() const {
+            return num_docked_enemies > 0;
+        }
+
+    private:
+        PlayerId player_id;
+        int num_rows = 0;
+        int num_docked_enemies = 0;
+
+        arena_vector<const Planet *> planets;
+        arena_vector<const Ship *> enemies;
+        arena_vector<int> row_by_id;
+
+        arena_vector<double> planet_distances;
+        arena_vector<double> enemy_distances;
+        // Not vector<bool>: rows of different ships may be filled from different threads.
+        arena_vector<char> planet_row_ready;
+        arena_vector<char> enemy_row_ready;
+        // Per row, target indices with the nearest sorted[row] of them in order.
+        arena_vector<unsigned int> planet_order;
+        arena_vector<unsigned int> enemy_order;
+        arena_vector<unsigned int> planet_sorted;
+        arena_vector<unsigned int> enemy_sorted;
+
+        int row_of(const Ship& ship) const {
+            if (ship.owner_id != player_id || ship.entity_id >= row_by_id.size() || row_by_id[ship.entity_id] < 0) {
+                throw std::out_of_range("DistanceCache: not one of this player's ships");
+            }
+            return row_by_id[ship.entity_id];
+        }
+
+        template<typename T>
+        static void fill_row(double* row, const Location& from, const arena_vector<const T *>& targets) {
+            for (size_t i = 0; i < targets.size(); ++i) {
+                const double dx = targets[i]->location.pos_x - from.pos_x;
+                const double dy = targets[i]->location.pos_y - from.pos_y;
+                row[i] = dx * dx + dy * dy;
+            }
+        }
+
+        const double* planet_row(const Ship& ship) {
+            const int row = row_of(ship);
+            double* distances = planet_distances.data() + static_cast<size_t>(row) * planets.size();
+            if (!planet_row_ready[row]) {
+                fill_row(distances, ship.location, planets);
+                planet_row_ready[row] = true;
+            }
+            return distances;
+        }
+
+        const double* enemy_row(const Ship& ship) {
+            const int row = row_of(ship);
+            double* distances = enemy_distances.data() + static_cast<size_t>(row) * enemies.size();
+            if (!enemy_row_ready[row]) {
+                fill_row(distances, ship.location, enemies);
+                enemy_row_ready[row] = true;
+            }
+            return distances;
+        }
+
+        /**
+         * The k nearest targets from a row's order. The order is kept, so
+         * asking again for as many (or for all, once sorted) costs nothing.
+         */
+        template<typename T>
+        static Ranking<T> ranked(
+                const arena_vector<const T *>& targets,
+                const double* distances,
+                unsigned int* order,
+                unsigned int& sorted,
+                const size_t k)
+        {
+            const size_t count = targets.size();
+            const size_t wanted = std::min(k, count);
+            if (sorted != count && sorted != wanted) {
+                for (unsigned int i = 0; i < count; ++i) {
+                    order[i] = i;
+                }
+                std::partial_sort(order, order + wanted, order + count, [distances](const unsigned int a, const unsigned int b) {
+                    return distances[a] < distances[b];
+                });
+                sorted = static_cast<unsigned int>(wanted);
+            }
+            return Ranking<T>(targets.data(), order, wanted);
+        }
+    };
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+
+#include "constants.hpp"
+#include "map.hpp"
+
+namespace hlt {
+    /**
+     * Structure-of-arrays copy of a Map for loops that touch every entity.
+     *
+     * All entities share one slot space: planets occupy [0, num_planets) and
+     * ships follow, grouped by owner in player id order. The columns below
+     * are indexed by slot; ship-only and planet-only columns are indexed by
+     * slot too, and are only meaningful in their own range.
+     *
+     * Lookups by id go through dense tables instead of hash maps, and docked
+     * ships live in one flat array addressed by per-planet ranges.
+     */
+    class EntityStore {
+    public:
+        struct Range {
+            unsigned int begin, end;
+
+            unsigned int size() const {
+                return end - begin;
+            }
+        };
+
+        /// Read-only handle to a ship slot, with the same fields as Ship.
+        struct ShipView {
+            const EntityStore* store;
+            unsigned int slot;
+
+            EntityId entity_id() const { return store->entity_id[slot]; }
+            PlayerId owner_id() const { return store->owner_id[slot]; }
+            Location location() const { return { store->pos_x[slot], store->pos_y[slot] }; }
+            int health() const { return store->health[slot]; }
+            double radius() const { return store->radius[slot]; }
+            int weapon_cooldown() const { return store->weapon_cooldown[slot]; }
+            ShipDockingStatus docking_status() const { return store->docking_status[slot]; }
+            int docking_progress() const { return store->docking_progress[slot]; }
+            EntityId docked_planet() const { return store->docked_planet[slot]; }
+
+            Ship to_ship() const {
+                Ship ship;
+                ship.entity_id = entity_id();
+                ship.owner_id = owner_id();
+                ship.location = location();
+                ship.health = health();
+                ship.radius = radius();
+                ship.weapon_cooldown = weapon_cooldown();
+                ship.docking_status = docking_status();
+                ship.docking_progress = docking_progress();
+                ship.docked_planet = docked_planet();
+                return ship;
+            }
+        };
+
+        /// Read-only handle to a planet slot, with the same fields as Planet.
+        struct PlanetView {
+            const EntityStore* store;
+            unsigned int slot;
+
+            EntityId entity_id() const { return store->entity_id[slot]; }
+            PlayerId owner_id() const { return store->owner_id[slot]; }
+            bool owned() const { return store->owner_id[slot] >= 0; }
+            Location location() const { return { store->pos_x[slot], store->pos_y[slot] }; }
+            int health() const { return store->health[slot]; }
+            double radius() const { return store->radius[slot]; }
+            unsigned int docking_spots() const { return store->docking_spots[slot]; }
+            int current_production() const { return store->current_production[slot]; }
+            int remaining_production() const { return store->remaining_production[slot]; }
+
+            /// Ids of docked ships, as a [first, last) pointer range into the flat array.
+            const EntityId* docked_begin() const { return store->docked_ships.data() + store->docked_start[slot]; }
+            const EntityId* docked_end() const { return store->docked_ships.data() + store->docked_start[slot + 1]; }
+            unsigned int num_docked() const { return store->docked_start[slot + 1] - store->docked_start[slot]; }
+
+            bool is_full() const {
+                return num_docked() == docking_spots();
+            }
+        };
+
+        int map_width, map_height;
+
+        // Columns shared by every entity.
+        std::vector<EntityId> entity_id;
+        std::vector<PlayerId> owner_id;
+        std::vector<double> pos_x;
+        std::vector<double> pos_y;
+        std::vector<double> radius;
+        std::vector<int> health;
+
+        // Ship columns.
+        std::vector<int> weapon_cooldown;
+        std::vector<ShipDockingStatus> docking_status;
+        std::vector<int> docking_progress;
+        std::vector<EntityId> docked_planet;
+
+        // Planet columns; docked_start has one extra entry closing the last range.
+        std::vector<unsigned int> docking_spots;
+        std::vector<int> current_production;
+        std::vector<int> remaining_production;
+        std::vector<unsigned int> docked_start;
+        std::vector<EntityId> docked_ships;
+
+        EntityStore() : map_width(0), map_height(0), num_planets(0) {
+        }
+
+        explicit EntityStore(const Map& map) : EntityStore() {
+            assign(map);
+        }
+
+        /// Rebuild from a Map, reusing the storage of the previous turn.
+        void assign(const Map& map) {
+            map_width = map.map_width;
+            map_height = map.map_height;
+            num_planets = static_cast<unsigned int>(map.planets.size());
+
+            unsigned int num_ships = 0;
+            for (const auto& player_ships : map.ships) {
+                num_ships += static_cast<unsigned int>(player_ships.second.size());
+            }
+            resize(num_planets + num_ships);
+
+            docked_start.clear();
+            docked_ships.clear();
+            planet_slot_by_id.clear();
+            for (unsigned int slot = 0; slot < num_planets; ++slot) {
+                const Planet& planet = map.planets[slot];
+                set_entity(slot, planet);
+                owner_id[slot] = planet.owned ? planet.owner_id : -1;
+                docking_spots[slot] = planet.docking_spots;
+                current_production[slot] = planet.current_production;
+                remaining_production[slot] = planet.remaining_production;
+                docked_start.push_back(static_cast<unsigned int>(docked_ships.size()));
+                docked_ships.insert(docked_ships.end(), planet.docked_ships.begin(), planet.docked_ships.end());
+                set_slot(planet_slot_by_id, planet.entity_id, slot);
+            }
+            docked_start.push_back(static_cast<unsigned int>(docked_ships.size()));
+
+            unsigned int slot = num_planets;
+            for (PlayerId player_id = 0; player_id < constants::MAX_PLAYERS; ++player_id) {
+                player_begin[player_id] = slot;
+                ship_slot_by_id[player_id].clear();
+
+                const auto it = map.ships.find(player_id);
+                if (it == map.ships.end()) {
+                    continue;
+                }
+                for (const Ship& ship : it->second) {
+                    set_entity(slot, ship);
+                    weapon_cooldown[slot] = ship.weapon_cooldown;
+                    docking_status[slot] = ship.docking_status;
+                    docking_progress[slot] = ship.docking_progress;
+                    docked_planet[slot] = ship.docked_planet;
+                    set_slot(ship_slot_by_id[player_id], ship.entity_id, slot);
+                    ++slot;
+                }
+            }
+            player_begin[constants::MAX_PLAYERS] = slot;
+        }
+
+        unsigned int size() const {
+            return static_cast<unsigned int>(entity_id.size());
+        }
+
+        Range planets() const {
+            return { 0, num_planets };
+        }
+
+        Range ships() const {
+            return { num_planets, size() };
+        }
+
+        Range ships(const PlayerId player_id) const {
+            return { player_begin[player_id], player_begin[player_id + 1] };
+        }
+
+        ShipView ship_at(const unsigned int slot) const {
+            return { this, slot };
+        }
+
+        PlanetView planet_at(const unsigned int slot) const {
+            return { this, slot };
+        }
+
+        /// Slot of a ship, or -1 if that player has no such ship.
+        int ship_slot(const PlayerId player_id, const EntityId ship_id) const {
+            if (player_id < 0 || player_id >= constants::MAX_PLAYERS) {
+                return -1;
+            }
+            const std::vector<int>& slots = ship_slot_by_id[player_id];
+            return ship_id < slots.size() ? slots[ship_id] : -1;
+        }
+
+        /// Slot of a planet, or -1 if there is no such planet.
+        int planet_slot(const EntityId planet_id) const {
+            return planet_id < planet_slot_by_id.size() ? planet_slot_by_id[planet_id] : -1;
+        }
+
+        /// Like Map::get_ship, throws std::out_of_range if that player has no such ship.
+        ShipView get_ship(const PlayerId player_id, const EntityId ship_id) const {
+            const int slot = ship_slot(player_id, ship_id);
+            if (slot < 0) {
+                throw std::out_of_range("EntityStore::get_ship: no such ship");
+            }
+            return ship_at(static_cast<unsigned int>(slot));
+        }
+
+        /// Like Map::get_planet, throws std::out_of_range if there is no such planet.
+        PlanetView get_planet(const EntityId planet_id) const {
+            const int slot = planet_slot(planet_id);
+            if (slot < 0) {
+                throw std::out_of_range("EntityStore::get_planet: no such planet");
+            }
+            return planet_at(static_cast<unsigned int>(slot));
+        }
+
+    private:
+        unsigned int num_planets;
+        unsigned int player_begin[constants::MAX_PLAYERS + 1];
+
+        std::vector<int> ship_slot_by_id[constants::MAX_PLAYERS];
+        std::vector<int> planet_slot_by_id;
+
+        void resize(const unsigned int count) {
+            entity_id.resize(count);
+            owner_id.resize(count);
+            pos_x.resize(count);
+            pos_y.resize(count);
+            radius.resize(count);
+            health.resize(count);
+            weapon_cooldown.resize(count);
+            docking_status.resize(count);
+            docking_progress.resize(count);
+            docked_planet.resize(count);
+            docking_spots.resize(count);
+            current_production.resize(count);
+            remaining_production.resize(count);
+        }
+
+        void set_entity(const unsigned int slot, const Entity& entity) {
+            entity_id[slot] = entity.entity_id;
+            owner_id[slot] = entity.owner_id;
+            pos_x[slot] = entity.location.pos_x;
+            pos_y[slot] = entity.location.pos_y;
+            radius[slot] = entity.radius;
+            health[slot] = entity.health;
+        }
+
+        static void set_slot(std::vector<int>& slots, const EntityId id, const unsigned int slot) {
+            if (id >= slots.size()) {
+                slots.resize(id + 1, -1);
+            }
+            slots[id] = static_cast<int>(slot);
+        }
+    };
+}
@@ -0,0 +1,507 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "constants.hpp"
+#include "map.hpp"
+
+namespace hlt {
+    /**
+     * Travel distance to one goal from every point of a grid over the map,
+     * going around the planets; see FlowFields. Between grid points the
+     * distance is interpolated bilinearly, and a ship anywhere heads
+     * downhill.
+     */
+    class FlowField {
+    public:
+        /// Distance to the goal from location, or infinity where the goal cannot be reached.
+        double distance(const Location& location) const {
+            Cell cell;
+            return corners(location, cell) ? cell.interpolate() : INFINITY;
+        }
+
+        /**
+         * Unit vector downhill at location, into dx and dy, plus the
+         * gradient of the optional extra potential scaled by weight. False
+         * where the field is flat or unknown.
+         */
+        bool downhill(const Location& location, double& dx, double& dy,
+                      const std::vector<float>* extra = nullptr, const double weight = 0) const {
+            Cell cell;
+            if (!corners(location, cell)) {
+                return false;
+            }
+            cell.gradient(dx, dy);
+            if (extra != nullptr) {
+                const size_t at = cell.index;
+                const double e00 = (*extra)[at];
+                const double e10 = (*extra)[at + 1];
+                const double e01 = (*extra)[at + cols];
+                const double e11 = (*extra)[at + cols + 1];
+                dx += weight * ((1 - cell.v) * (e10 - e00) + cell.v * (e11 - e01)) / cell_size;
+                dy += weight * ((1 - cell.u) * (e01 - e00) + cell.u * (e11 - e10)) / cell_size;
+            }
+            const double length = std::sqrt(dx * dx + dy * dy);
+            if (length == 0) {
+                return false;
+            }
+            dx = -dx / length;
+            dy = -dy / length;
+            return true;
+        }
+
+    private:
+        friend class FlowFields;
+
+        double cell_size = 1;
+        int cols = 0;
+        int rows = 0;
+        /// Distance of grid point (col, row) at [row * cols + col]; infinity inside planets and out of reach.
+        std::vector<float> times;
+
+        /// The four grid points around a location, and where in between it is.
+        struct Cell {
+            size_t index;
+            double u, v;
+            double t00, t10, t01, t11;
+            double cell_size;
+
+            double interpolate() const {
+                return (1 - v) * ((1 - u) * t00 + u * t10) + v * ((1 - u) * t01 + u * t11);
+            }
+
+            void gradient(double& dx, double& dy) const {
+                dx = ((1 - v) * (t10 - t00) + v * (t11 - t01)) / cell_size;
+                dy = ((1 - u) * (t01 - t00) + u * (t11 - t10)) / cell_size;
+            }
+        };
+
+        /**
+         * Fill cell for location. Points inside a planet or out of reach
+         * take a cell's length more than the farthest of the other three,
+         * so the slope leads away from them; false if all four are.
+         */
+        bool corners(const Location& location, Cell& cell) const {
+            if (times.empty()) {
+                return false;
+            }
+            const double x = std::max(0.0, std::min(location.pos_x / cell_size, cols - 1.000001));
+            const double y = std::max(0.0, std::min(location.pos_y / cell_size, rows - 1.000001));
+            const int col = static_cast<int>(x);
+            const int row = static_cast<int>(y);
+            cell.index = static_cast<size_t>(row) * cols + col;
+            cell.u = x - col;
+            cell.v = y - row;
+            cell.cell_size = cell_size;
+            double* const values[4] = { &cell.t00, &cell.t10, &cell.t01, &cell.t11 };
+            const size_t at[4] = { cell.index, cell.index + 1, cell.index + cols, cell.index + cols + 1 };
+            double highest = -INFINITY;
+            for (int k = 0; k < 4; ++k) {
+                *values[k] = times[at[k]];
+                if (std::isfinite(*values[k])) {
+                    highest = std::max(highest, *values[k]);
+                }
+            }
+            if (!std::isfinite(highest)) {
+                return false;
+            }
+            for (int k = 0; k < 4; ++k) {
+                if (!std::isfinite(*values[k])) {
+                    *values[k] = highest + cell_size;
+                }
+            }
+            return true;
+        }
+    };
+
+    /**
+     * Flow fields over one map: a FlowField towards the docking ring of
+     * every planet, built by fast marching from the pre-game map (planets
+     * never move) and again by begin_turn() once a planet is destroyed, and
+     * fields towards any other circle, such as a group of enemy ships,
+     * built on demand and kept for the turn.
+     *
+     * Many ships headed for the same planet then share one field, and
+     * finding each one's heading is a grid lookup.
+     *
+     * Enemy ships make a threat potential over the same grid, updated each
+     * turn only where enemies came, went or moved. It pushes headings from
+     * the planet fields away from enemies, and slows travel through the
+     * fields built on demand, so those go around them.
+     *
+     * Not thread safe while begin_turn() or toward() run; the other queries
+     * only read.
+     */
+    class FlowFields {
+    public:
+        /// How far an undocked enemy ship is felt: it can move this close and fire next turn.
+        static constexpr double THREAT_RANGE = constants::WEAPON_RADIUS + 2 * constants::SHIP_RADIUS + constants::MAX_SPEED;
+        /// Threat potential at an enemy's position, fading to zero at THREAT_RANGE, in the units of distance.
+        static constexpr double THREAT_PEAK = 4.0;
+        /// How much of the threat potential's slope is added to a planet field's.
+        static constexpr double THREAT_WEIGHT = 1.0;
+        /// Fields built on demand count travel through threat as 1 + this per unit of potential.
+        static constexpr double THREAT_SLOWNESS = 0.25;
+
+        FlowFields() {
+        }
+
+        /// Grid over initial_map's living planets with the given spacing, and the field of every one.
+        explicit FlowFields(const Map& initial_map, const double cell_size = constants::FLOW_FIELD_CELL_SIZE) {
+            build(initial_map, cell_size);
+        }
+
+        void build(const Map& initial_map, const double cell_size) {
+            this->cell_size = cell_size;
+            cols = static_cast<int>(initial_map.map_width / cell_size) + 2;
+            rows = static_cast<int>(initial_map.map_height / cell_size) + 2;
+            const size_t size = static_cast<size_t>(cols) * rows;
+
+            threat.assign(size, 0);
+            threat_units.assign(size, 0);
+            stamped.clear();
+            stencil.clear();
+            const int reach = static_cast<int>(THREAT_RANGE / cell_size);
+            for (int row = -reach; row <= reach; ++row) {
+                for (int col = -reach; col <= reach; ++col) {
+                    const double distance = std::sqrt(static_cast<double>(col * col + row * row)) * cell_size;
+                    if (distance <= THREAT_RANGE) {
+                        stencil.push_back({ col, row, static_cast<int>(THREAT_PEAK * (1 - distance / THREAT_RANGE) / THREAT_UNIT) });
+                    }
+                }
+            }
+            on_demand.clear();
+            num_on_demand = 0;
+
+            build_planet_fields(initial_map);
+        }
+
+        /// The field towards the docking ring of planet id, or nullptr for a planet not on the map or destroyed.
+        const FlowField* planet(const EntityId id) const {
+            return id < planet_index.size() && planet_index[id] >= 0 ? &planets[planet_index[id]] : nullptr;
+        }
+
+        /**
+         * Update the threat potential to the undocked enemy ships of map,
+         * for player_id, and drop the fields built on demand last turn. If
+         * planets were destroyed since, the fields of the others are built
+         * again, as paths may now cross where they were.
+         */
+        void begin_turn(const Map& map, const PlayerId player_id) {
+            // Planets are never added, so fewer living ones means some were destroyed.
+            const size_t alive = static_cast<size_t>(std::count_if(map.planets.begin(), map.planets.end(), [](const Planet& planet) {
+                return planet.is_alive();
+            }));
+            if (alive != planets.size()) {
+                build_planet_fields(map);
+            }
+
+            current.clear();
+            for (const auto& player_ships : map.ships) {
+                if (player_ships.first == player_id) {
+                    continue;
+                }
+                for (const Ship& ship : player_ships.second) {
+                    if (ship.docking_status == ShipDockingStatus::Undocked) {
+                        current.push_back({ ship.owner_id, ship.entity_id, nearest_col(ship.location), nearest_row(ship.location) });
+                    }
+                }
+            }
+            std::sort(current.begin(), current.end());
+
+            // Both lists are sorted by ship: walk them together and only touch what changed.
+            size_t old = 0;
+            for (const Stamp& stamp : current) {
+                while (old < stamped.size() && stamped[old] < stamp) {
+                    add_threat(stamped[old++], -1);
+                }
+                if (old < stamped.size() && !(stamp < stamped[old])) {
+                    if (stamped[old].col == stamp.col && stamped[old].row == stamp.row) {
+                        ++old;
+                        continue;
+                    }
+                    add_threat(stamped[old++], -1);
+                }
+                add_threat(stamp, 1);
+            }
+            while (old < stamped.size()) {
+                add_threat(stamped[old++], -1);
+            }
+            stamped.swap(current);
+
+            num_on_demand = 0;
+        }
+
+        /**
+         * A field towards the circle around center, built now unless one
+         * was already built this turn, going around enemy threat. It stays
+         * where it is until the next begin_turn().
+         */
+        const FlowField& toward(const Location& center, const double radius) {
+            for (size_t i = 0; i < num_on_demand; ++i) {
+                if (on_demand[i].center == center && on_demand[i].radius == radius) {
+                    return on_demand[i].field;
+                }
+            }
+            if (num_on_demand == on_demand.size()) {
+                on_demand.emplace_back();
+            }
+            OnDemand& entry = on_demand[num_on_demand++];
+            entry.center = center;
+            entry.radius = radius;
+            march(center, radius, true, entry.field);
+            return entry.field;
+        }
+
+        /**
+         * The point distance away from from that a ship following field
+         * should steer for, pushed away from enemies by the threat
+         * potential; false where the field gives no heading.
+         */
+        possibly<Location> aim(const FlowField& field, const Location& from, const double distance) const {
+            double dx, dy;
+            if (!field.downhill(from, dx, dy, &threat, THREAT_WEIGHT)) {
+                return { from, false };
+            }
+            return { { from.pos_x + distance * dx, from.pos_y + distance * dy }, true };
+        }
+
+        /// Threat potential at the grid point nearest to location.
+        double threat_at(const Location& location) const {
+            return threat[static_cast<size_t>(nearest_row(location)) * cols + nearest_col(location)];
+        }
+
+    private:
+        /// An enemy ship as stamped on the threat potential, at the grid point nearest to it.
+        struct Stamp {
+            PlayerId owner;
+            EntityId id;
+            int col, row;
+
+            bool operator<(const Stamp& other) const {
+                return owner < other.owner || (owner == other.owner && id < other.id);
+            }
+        };
+
+        /// The threat one ship adds at a grid point this far from the one it is stamped at.
+        struct StencilPoint {
+            int col, row;
+            int units;
+        };
+
+        struct OnDemand {
+            Location center;
+            double radius;
+            FlowField field;
+        };
+
+        /// Width of the time buckets of march(), as a part of cell_size: the most it may take points out of order.
+        static constexpr double BUCKET_FRACTION = 0.25;
+        /// Threat is added up in these steps, so taking a stamp off leaves exactly what was there.
+        static constexpr double THREAT_UNIT = 1.0 / 1024;
+
+        // The grid every field covers: point (col, row) is at (col, row) * cell_size.
+        double cell_size = 1;
+        int cols = 0;
+        int rows = 0;
+        /// Grid points inside a living inflated planet.
+        std::vector<unsigned char> blocked;
+        std::vector<FlowField> planets;
+        /// Fields of the living planets; index into planets by planet id, or -1.
+        std::vector<int> planet_index;
+
+        /// threat_units times THREAT_UNIT, as read by the fields.
+        std::vector<float> threat;
+        std::vector<int> threat_units;
+        /// The enemies on the threat potential, sorted by ship.
+        std::vector<Stamp> stamped;
+        /// Scratch for begin_turn().
+        std::vector<Stamp> current;
+        std::vector<StencilPoint> stencil;
+
+        /// Fields built this turn are on_demand[0, num_on_demand); the rest keep their storage. A deque, so adding one moves none.
+        std::deque<OnDemand> on_demand;
+        size_t num_on_demand = 0;
+
+        /// Scratch for march(), which uses as many of the buckets as its longest step needs.
+        std::vector<unsigned char> known;
+        std::vector<std::vector<unsigned int>> buckets;
+
+        /// Call visit(point, distance) for every grid point within radius of center.
+        template<typename Visit>
+        void for_each_point_within(const Location& center, const double radius, Visit visit) const {
+            const int col_from = std::max(0, static_cast<int>(std::ceil((center.pos_x - radius) / cell_size)));
+            const int col_to = std::min(cols - 1, static_cast<int>(std::floor((center.pos_x + radius) / cell_size)));
+            const int row_from = std::max(0, static_cast<int>(std::ceil((center.pos_y - radius) / cell_size)));
+            const int row_to = std::min(rows - 1, static_cast<int>(std::floor((center.pos_y + radius) / cell_size)));
+            for (int row = row_from; row <= row_to; ++row) {
+                for (int col = col_from; col <= col_to; ++col) {
+                    const double dx = col * cell_size - center.pos_x;
+                    const double dy = row * cell_size - center.pos_y;
+                    const double distance = std::sqrt(dx * dx + dy * dy);
+                    if (distance <= radius) {
+                        visit(static_cast<size_t>(row) * cols + col, distance);
+                    }
+                }
+            }
+        }
+
+        /// Mark the grid points inside the living planets of map, and march the field of each.
+        void build_planet_fields(const Map& map) {
+            blocked.assign(static_cast<size_t>(cols) * rows, 0);
+            for (const Planet& planet : map.planets) {
+                if (!planet.is_alive()) {
+                    continue;
+                }
+                const double reach = planet.radius + constants::FORECAST_FUDGE_FACTOR;
+                for_each_point_within(planet.location, reach, [&](const size_t i, double) {
+                    blocked[i] = 1;
+                });
+            }
+
+            planet_index.clear();
+            planets.clear();
+            for (const Planet& planet : map.planets) {
+                if (!planet.is_alive()) {
+                    continue;
+                }
+                if (planet_index.size() <= planet.entity_id) {
+                    planet_index.resize(planet.entity_id + 1, -1);
+                }
+                planet_index[planet.entity_id] = static_cast<int>(planets.size());
+                planets.emplace_back();
+                march(planet.location, planet.radius + constants::DOCK_RADIUS, false, planets.back());
+            }
+        }
+
+        int nearest_col(const Location& location) const {
+            return std::max(0, std::min(cols - 1, static_cast<int>(std::round(location.pos_x / cell_size))));
+        }
+
+        int nearest_row(const Location& location) const {
+            return std::max(0, std::min(rows - 1, static_cast<int>(std::round(location.pos_y / cell_size))));
+        }
+
+        void add_threat(const Stamp& stamp, const int sign) {
+            for (const StencilPoint& point : stencil) {
+                const int col = stamp.col + point.col;
+                const int row = stamp.row + point.row;
+                if (col < 0 || col >= cols || row < 0 || row >= rows) {
+                    continue;
+                }
+                const size_t i = static_cast<size_t>(row) * cols + col;
+                threat_units[i] += sign * point.units;
+                threat[i] = static_cast<float>(threat_units[i] * THREAT_UNIT);
+            }
+        }
+
+        /**
+         * Fast marching from the grid points within radius of goal, outside
+         * the planets, into field: first order upwind updates of the eikonal
+         * equation, so distances are close to straight-line ones rather than
+         * the 8-way steps of a plain Dijkstra.
+         *
+         * Points wait in buckets of times instead of a heap (the "untidy"
+         * queue of Yatziv, Bartesaghi and Sapiro), so each update is O(1) and
+         * a point is at worst a bucket's width late.
+         */
+        void march(const Location& goal, const double radius, const bool around_threat, FlowField& field) {
+            field.cell_size = cell_size;
+            field.cols = cols;
+            field.rows = rows;
+            field.times.assign(static_cast<size_t>(cols) * rows, INFINITY);
+            known.assign(field.times.size(), 0);
+
+            // No update takes a point more than one step past the one it came from, so the
+            // buckets from the current one up to the longest step are all that is ever in use.
+            double max_threat = 0;
+            if (around_threat) {
+                max_threat = *std::max_element(threat.begin(), threat.end());
+            }
+            const double width = cell_size * BUCKET_FRACTION;
+            const double max_step = cell_size * (1 + THREAT_SLOWNESS * max_threat);
+            // Only ever grown, so the buckets keep their storage from march to march.
+            const size_t num_buckets = static_cast<size_t>(max_step / width) + 2;
+            if (num_buckets > buckets.size()) {
+                const size_t old_size = buckets.size();
+                buckets.resize(num_buckets);
+                // Room for a front around the whole grid, so a bucket hardly ever has to grow mid-march.
+                for (size_t k = old_size; k < num_buckets; ++k) {
+                    buckets[k].reserve(2 * static_cast<size_t>(cols + rows));
+                }
+            }
+            for (size_t k = 0; k < num_buckets; ++k) {
+                buckets[k].clear();
+            }
+            size_t current = 0;
+            size_t waiting = 0;
+            const auto bucket_of = [&](const double time) {
+                return std::max(current, static_cast<size_t>(time / width));
+            };
+
+            std::vector<float>& times = field.times;
+            for_each_point_within(goal, radius, [&](const size_t i, double) {
+                if (!blocked[i]) {
+                    times[i] = 0;
+                    buckets[0].push_back(static_cast<unsigned int>(i));
+                    ++waiting;
+                }
+            });
+
+            const auto known_time = [&](const int col, const int row) {
+                if (col < 0 || col >= cols || row < 0 || row >= rows) {
+                    return static_cast<double>(INFINITY);
+                }
+                const size_t i = static_cast<size_t>(row) * cols + col;
+                return known[i] ? static_cast<double>(times[i]) : static_cast<double>(INFINITY);
+            };
+
+            for (; waiting > 0; ++current) {
+                std::vector<unsigned int>& bucket = buckets[current % num_buckets];
+                // Points may be added to this bucket while it is being emptied.
+                for (size_t k = 0; k < bucket.size(); ++k) {
+                    const unsigned int point = bucket[k];
+                    --waiting;
+                    if (known[point] || bucket_of(times[point]) != current) {
+                        continue;
+                    }
+                    known[point] = 1;
+                    const int col = static_cast<int>(point % cols);
+                    const int row = static_cast<int>(point / cols);
+
+                    const int neighbours[4][2] = { { col - 1, row }, { col + 1, row }, { col, row - 1 }, { col, row + 1 } };
+                    for (const auto& neighbour : neighbours) {
+                        const int c = neighbour[0];
+                        const int r = neighbour[1];
+                        if (c < 0 || c >= cols || r < 0 || r >= rows) {
+                            continue;
+                        }
+                        const size_t n = static_cast<size_t>(r) * cols + c;
+                        if (known[n] || blocked[n]) {
+                            continue;
+                        }
+                        const double a = std::min(known_time(c - 1, r), known_time(c + 1, r));
+                        const double b = std::min(known_time(c, r - 1), known_time(c, r + 1));
+                        const double step = cell_size * (around_threat ? 1 + THREAT_SLOWNESS * threat[n] : 1);
+                        double time;
+                        if (std::fabs(a - b) >= step) {
+                            time = std::min(a, b) + step;
+                        } else {
+                            time = (a + b + std::sqrt(2 * step * step - (a - b) * (a - b))) / 2;
+                        }
+                        if (time < times[n]) {
+                            times[n] = static_cast<float>(time);
+                            buckets[bucket_of(times[n]) % num_buckets].push_back(static_cast<unsigned int>(n));
+                            ++waiting;
+                        }
+                    }
+                }
+                bucket.clear();
+            }
+        }
+    };
+}
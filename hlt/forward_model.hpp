@@ -0,0 +1,739 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "constants.hpp"
+#include "kinematics.hpp"
+#include "map.hpp"
+#include "move.hpp"
+
+namespace hlt {
+    /**
+     * The whole game state as flat vectors of plain structs, so a snapshot
+     * is a couple of memcpys and copying into an existing state reuses its
+     * storage. See ForwardModel.
+     */
+    struct ForwardState {
+        struct ShipState : Ship {
+            /// When the ship docked, to keep each planet's docked_ships in the engine's order.
+            unsigned int dock_order;
+        };
+
+        struct PlanetState : Entity {
+            bool owned;
+            int remaining_production;
+            int current_production;
+            unsigned int docking_spots;
+            /// Ships docking, docked or undocking here.
+            unsigned int num_docked;
+        };
+
+        int map_width = 0;
+        int map_height = 0;
+        int num_players = 0;
+        int turn = 0;
+        EntityId next_ship_id = 0;
+        unsigned int next_dock_order = 0;
+
+        /// By owner, then id: the order the engine handles ships in.
+        std::vector<ShipState> ships;
+        /// By id.
+        std::vector<PlanetState> planets;
+
+        ForwardState() = default;
+
+        ForwardState(const Map& map, const int num_players) :
+                map_width(map.map_width), map_height(map.map_height), num_players(num_players) {
+            for (PlayerId player_id = 0; player_id < num_players; ++player_id) {
+                const auto player_ships = map.ships.find(player_id);
+                if (player_ships == map.ships.end()) {
+                    continue;
+                }
+                for (const Ship& ship : player_ships->second) {
+                    ShipState state;
+                    static_cast<Ship&>(state) = ship;
+                    state.dock_order = 0;
+                    ships.push_back(state);
+                    next_ship_id = std::max(next_ship_id, ship.entity_id + 1);
+                }
+            }
+            std::sort(ships.begin(), ships.end(), engine_order);
+
+            for (const Planet& planet : map.planets) {
+                PlanetState state;
+                static_cast<Entity&>(state) = planet;
+                state.owned = planet.owned;
+                state.remaining_production = planet.remaining_production;
+                state.current_production = planet.current_production;
+                state.docking_spots = planet.docking_spots;
+                state.num_docked = static_cast<unsigned int>(planet.docked_ships.size());
+                planets.push_back(state);
+            }
+            std::sort(planets.begin(), planets.end(), [](const PlanetState& a, const PlanetState& b) {
+                return a.entity_id < b.entity_id;
+            });
+
+            for (const Planet& planet : map.planets) {
+                for (const EntityId ship_id : planet.docked_ships) {
+                    if (ShipState* ship = find_ship(planet.owner_id, ship_id)) {
+                        ship->dock_order = next_dock_order++;
+                    }
+                }
+            }
+        }
+
+        static bool engine_order(const ShipState& a, const ShipState& b) {
+            return a.owner_id != b.owner_id ? a.owner_id < b.owner_id : a.entity_id < b.entity_id;
+        }
+
+        ShipState* find_ship(const PlayerId owner_id, const EntityId ship_id) {
+            ShipState key;
+            key.owner_id = owner_id;
+            key.entity_id = ship_id;
+            const auto found = std::lower_bound(ships.begin(), ships.end(), key, engine_order);
+            return found != ships.end() && found->owner_id == owner_id && found->entity_id == ship_id ? &*found : nullptr;
+        }
+
+        const ShipState* find_ship(const PlayerId owner_id, const EntityId ship_id) const {
+            return const_cast<ForwardState*>(this)->find_ship(owner_id, ship_id);
+        }
+
+        PlanetState* find_planet(const EntityId planet_id) {
+            const auto found = std::lower_bound(
+                    planets.begin(), planets.end(), planet_id,
+                    [](const PlanetState& planet, const EntityId id) { return planet.entity_id < id; });
+            return found != planets.end() && found->entity_id == planet_id ? &*found : nullptr;
+        }
+
+        const PlanetState* find_planet(const EntityId planet_id) const {
+            return const_cast<ForwardState*>(this)->find_planet(planet_id);
+        }
+
+        int ship_count(const PlayerId player_id) const {
+            int count = 0;
+            for (const ShipState& ship : ships) {
+                count += ship.owner_id == player_id;
+            }
+            return count;
+        }
+
+        /// Write the state out as a Map, e.g. for a frame or a strategy; map's storage is reused.
+        void to_map(Map& map) const {
+            map.map_width = map_width;
+            map.map_height = map_height;
+            map.generation = Map::next_generation();
+            for (PlayerId player_id = 0; player_id < num_players; ++player_id) {
+                map.ships[player_id].clear();
+                map.ship_map[player_id].clear();
+            }
+            for (const ShipState& ship : ships) {
+                std::vector<Ship>& player_ships = map.ships[ship.owner_id];
+                map.ship_map[ship.owner_id][ship.entity_id] = static_cast<unsigned int>(player_ships.size());
+                player_ships.push_back(ship);
+            }
+
+            std::vector<const ShipState*> docked;
+            for (const ShipState& ship : ships) {
+                if (ship.docking_status != ShipDockingStatus::Undocked) {
+                    docked.push_back(&ship);
+                }
+            }
+            std::sort(docked.begin(), docked.end(), [](const ShipState* a, const ShipState* b) {
+                return a->dock_order < b->dock_order;
+            });
+
+            map.planets.resize(planets.size());
+            map.planet_map.clear();
+            for (size_t i = 0; i < planets.size(); ++i) {
+                const PlanetState& state = planets[i];
+                Planet& planet = map.planets[i];
+                static_cast<Entity&>(planet) = state;
+                planet.owned = state.owned;
+                planet.remaining_production = state.remaining_production;
+                planet.current_production = state.current_production;
+                planet.docking_spots = state.docking_spots;
+                planet.docked_ships.clear();
+                for (const ShipState* ship : docked) {
+                    if (ship->docked_planet == state.entity_id) {
+                        planet.docked_ships.push_back(ship->entity_id);
+                    }
+                }
+                map.planet_map[state.entity_id] = static_cast<unsigned int>(i);
+            }
+        }
+    };
+
+    /**
+     * The Halite II rules, applied to a ForwardState one turn at a time, for
+     * looking ahead from the current map as well as for running whole games.
+     *
+     * Each turn runs, in order: weapon cooldown, commands (thrust, dock,
+     * undock), movement with continuous collision checks, combat at the
+     * final positions, docking progress, then production and spawning.
+     * Invalid commands are ignored.
+     *
+     * Keeps its scratch buffers between steps, so after the first few steps
+     * rolling a copied state forward does not allocate. One model per
+     * thread; states can be shared freely.
+     */
+    class ForwardModel {
+    public:
+        /// Advance state by one turn. moves[player_id] holds that player's commands.
+        void step(ForwardState& state, const std::vector<std::vector<Move>>& moves) {
+            ++state.turn;
+
+            for (ForwardState::ShipState& ship : state.ships) {
+                if (ship.weapon_cooldown > 0) {
+                    --ship.weapon_cooldown;
+                }
+            }
+
+            velocities.assign(state.ships.size(), Location{ 0, 0 });
+            apply_commands(state, moves);
+            move_ships(state);
+            remove_dead(state);
+
+            resolve_combat(state);
+            remove_dead(state);
+
+            update_docking(state);
+            produce(state);
+        }
+
+        /// Drop destroyed ships and planets, and free the docking spots of the ships.
+        static void remove_dead(ForwardState& state) {
+            state.ships.erase(
+                    std::remove_if(state.ships.begin(), state.ships.end(), [](const ForwardState::ShipState& ship) {
+                        return !ship.is_alive();
+                    }),
+                    state.ships.end());
+            state.planets.erase(
+                    std::remove_if(state.planets.begin(), state.planets.end(), [](const ForwardState::PlanetState& planet) {
+                        return !planet.is_alive();
+                    }),
+                    state.planets.end());
+
+            for (ForwardState::PlanetState& planet : state.planets) {
+                planet.num_docked = 0;
+            }
+            for (const ForwardState::ShipState& ship : state.ships) {
+                if (ship.docking_status != ShipDockingStatus::Undocked) {
+                    if (ForwardState::PlanetState* planet = state.find_planet(ship.docked_planet)) {
+                        ++planet->num_docked;
+                    }
+                }
+            }
+            for (ForwardState::PlanetState& planet : state.planets) {
+                if (planet.owned && planet.num_docked == 0) {
+                    release(planet);
+                }
+            }
+        }
+
+    private:
+        static constexpr unsigned int NONE = ~0u;
+
+        /// Attempts at placing a newly produced ship before giving up for this turn.
+        static const int SPAWN_ATTEMPTS = 36;
+
+        /**
+         * Ships within this distance of each other on both axes may touch
+         * during a turn (two radii and two full moves apart) or fire at each
+         * other (two radii and WEAPON_RADIUS apart), so each ship only looks
+         * at the 3x3 grid cells around its own.
+         */
+        static constexpr double CELL_SIZE = 2 * constants::SHIP_RADIUS + 2 * constants::MAX_SPEED;
+
+        /// A collision during movement, by index into state.ships.
+        struct Event {
+            double time;
+            unsigned int ship;
+            /// Leaving the map first, then planets, then other ships, as the engine finds them.
+            int kind;
+            /// Other ship index, planet index, or NONE for leaving the map.
+            unsigned int other;
+        };
+
+        /// A ship's dock command; seq keeps the order commands were given in.
+        struct DockRequest {
+            unsigned int planet;
+            unsigned int ship;
+            unsigned int seq;
+        };
+
+        std::vector<Location> velocities;
+        std::vector<char> commanded;
+        std::vector<DockRequest> dock_requests;
+        std::vector<Event> events;
+        std::vector<int> damage;
+        std::vector<unsigned int> targets;
+        std::vector<unsigned int> docked_counts;
+
+        // Ships bucketed by grid cell, rebuilt when positions change.
+        int grid_width = 0;
+        int grid_height = 0;
+        std::vector<unsigned int> cell_start;
+        std::vector<unsigned int> cell_entries;
+
+        static void release(ForwardState::PlanetState& planet) {
+            planet.owned = false;
+            planet.owner_id = -1;
+            planet.current_production = 0;
+        }
+
+        /**
+         * Earliest time in [0, 1] at which a circle moving by (dvx, dvy) from
+         * offset (dx, dy) comes within reach of the origin, or -1 if it does
+         * not. Circles already touching only count when closing in.
+         */
+        static double contact_time(const double dx, const double dy, const double dvx, const double dvy, const double reach) {
+            const double c = dx * dx + dy * dy - reach * reach;
+            const double half_b = dx * dvx + dy * dvy;
+            if (c <= 0) {
+                return half_b < 0 ? 0 : -1;
+            }
+            const double a = dvx * dvx + dvy * dvy;
+            if (a == 0 || half_b >= 0) {
+                return -1;
+            }
+            const double discriminant = half_b * half_b - a * c;
+            if (discriminant < 0) {
+                return -1;
+            }
+            const double time = (-half_b - std::sqrt(discriminant)) / a;
+            return time <= 1 ? time : -1;
+        }
+
+        /// Time at which a ship moving by velocity leaves the map, or -1 if it stays inside.
+        static double exit_time(const Location& location, const Location& velocity, const int width, const int height) {
+            double time = 2;
+            const double x = location.pos_x + velocity.pos_x;
+            const double y = location.pos_y + velocity.pos_y;
+            if (x < 0) {
+                time = std::min(time, -location.pos_x / velocity.pos_x);
+            } else if (x > width) {
+                time = std::min(time, (width - location.pos_x) / velocity.pos_x);
+            }
+            if (y < 0) {
+                time = std::min(time, -location.pos_y / velocity.pos_y);
+            } else if (y > height) {
+                time = std::min(time, (height - location.pos_y) / velocity.pos_y);
+            }
+            return time <= 1 ? time : -1;
+        }
+
+        static Location position_at(const Ship& ship, const Location& velocity, const double time) {
+            return { ship.location.pos_x + velocity.pos_x * time, ship.location.pos_y + velocity.pos_y * time };
+        }
+
+        int cell_of(const Location& location) const {
+            const int x = std::min(grid_width - 1, std::max(0, static_cast<int>(location.pos_x / CELL_SIZE)));
+            const int y = std::min(grid_height - 1, std::max(0, static_cast<int>(location.pos_y / CELL_SIZE)));
+            return y * grid_width + x;
+        }
+
+        void build_grid(const ForwardState& state) {
+            grid_width = std::max(1, static_cast<int>(std::ceil(state.map_width / CELL_SIZE)));
+            grid_height = std::max(1, static_cast<int>(std::ceil(state.map_height / CELL_SIZE)));
+            cell_start.assign(static_cast<size_t>(grid_width * grid_height + 1), 0);
+            for (const ForwardState::ShipState& ship : state.ships) {
+                ++cell_start[cell_of(ship.location)];
+            }
+            for (size_t cell = 1; cell < cell_start.size(); ++cell) {
+                cell_start[cell] += cell_start[cell - 1];
+            }
+            cell_entries.resize(state.ships.size());
+            // Each cell's count ends at its end; filling back to front moves it to its start.
+            for (size_t i = state.ships.size(); i-- > 0;) {
+                cell_entries[--cell_start[cell_of(state.ships[i].location)]] = static_cast<unsigned int>(i);
+            }
+        }
+
+        /// Call visit(j) for every ship in the 3x3 cells around location.
+        template<typename Visit>
+        void for_each_nearby(const Location& location, Visit visit) const {
+            const int cell = cell_of(location);
+            const int cx = cell % grid_width;
+            const int cy = cell / grid_width;
+            for (int y = std::max(0, cy - 1); y <= std::min(grid_height - 1, cy + 1); ++y) {
+                for (int x = std::max(0, cx - 1); x <= std::min(grid_width - 1, cx + 1); ++x) {
+                    const int neighbor = y * grid_width + x;
+                    for (unsigned int k = cell_start[neighbor]; k < cell_start[neighbor + 1]; ++k) {
+                        visit(cell_entries[k]);
+                    }
+                }
+            }
+        }
+
+        void apply_commands(ForwardState& state, const std::vector<std::vector<Move>>& moves) {
+            commanded.assign(state.ships.size(), 0);
+            dock_requests.clear();
+
+            for (PlayerId player_id = 0; player_id < state.num_players && player_id < (int) moves.size(); ++player_id) {
+                for (const Move& move : moves[player_id]) {
+                    if (move.type == MoveType::Noop) {
+                        continue;
+                    }
+                    ForwardState::ShipState* found = state.find_ship(player_id, move.ship_id);
+                    if (found == nullptr) {
+                        continue;
+                    }
+                    const unsigned int index = static_cast<unsigned int>(found - state.ships.data());
+                    if (commanded[index]) {
+                        continue;
+                    }
+                    commanded[index] = 1;
+
+                    Ship& ship = *found;
+                    switch (move.type) {
+                        case MoveType::Thrust: {
+                            if (ship.docking_status != ShipDockingStatus::Undocked
+                                || move.move_thrust < 0 || move.move_thrust > constants::MAX_SPEED) {
+                                break;
+                            }
+                            if (move.move_angle_deg % 360 >= 0) {
+                                const kinematics::Offset offset = kinematics::offset(move.move_thrust, move.move_angle_deg);
+                                velocities[index] = { offset.dx, offset.dy };
+                            } else {
+                                // Negative headings turn the other way round; the table only holds [0, 360).
+                                const double angle_rad = (move.move_angle_deg % 360) * M_PI / 180.0;
+                                velocities[index] = { move.move_thrust * std::cos(angle_rad), move.move_thrust * std::sin(angle_rad) };
+                            }
+                            break;
+                        }
+                        case MoveType::Dock: {
+                            const ForwardState::PlanetState* planet = state.find_planet(move.dock_to);
+                            if (ship.docking_status == ShipDockingStatus::Undocked && planet != nullptr
+                                && ship.location.get_distance_to(planet->location) <= constants::DOCK_RADIUS + planet->radius) {
+                                dock_requests.push_back({ static_cast<unsigned int>(planet - state.planets.data()), index,
+                                                          static_cast<unsigned int>(dock_requests.size()) });
+                            }
+                            break;
+                        }
+                        case MoveType::Undock:
+                            if (ship.docking_status == ShipDockingStatus::Docked) {
+                                ship.docking_status = ShipDockingStatus::Undocking;
+                                ship.docking_progress = constants::DOCK_TURNS;
+                            }
+                            break;
+                        case MoveType::Noop:
+                            break;
+                    }
+                }
+            }
+
+            std::sort(dock_requests.begin(), dock_requests.end(), [](const DockRequest& a, const DockRequest& b) {
+                return a.planet != b.planet ? a.planet < b.planet : a.seq < b.seq;
+            });
+            for (size_t begin = 0; begin < dock_requests.size();) {
+                ForwardState::PlanetState& planet = state.planets[dock_requests[begin].planet];
+                const PlayerId owner = state.ships[dock_requests[begin].ship].owner_id;
+                size_t end = begin;
+                bool contested = false;
+                while (end < dock_requests.size() && dock_requests[end].planet == dock_requests[begin].planet) {
+                    contested |= state.ships[dock_requests[end].ship].owner_id != owner;
+                    ++end;
+                }
+
+                // Players racing for the same free planet all fail; nobody can dock on an enemy planet.
+                if (!(contested && !planet.owned) && (!planet.owned || planet.owner_id == owner)) {
+                    for (size_t i = begin; i < end && planet.num_docked < planet.docking_spots; ++i) {
+                        ForwardState::ShipState& ship = state.ships[dock_requests[i].ship];
+                        if (ship.owner_id != owner) {
+                            continue;
+                        }
+                        ship.docking_status = ShipDockingStatus::Docking;
+                        ship.docking_progress = constants::DOCK_TURNS;
+                        ship.docked_planet = planet.entity_id;
+                        ship.dock_order = state.next_dock_order++;
+                        ++planet.num_docked;
+                        planet.owned = true;
+                        planet.owner_id = owner;
+                    }
+                }
+                begin = end;
+            }
+        }
+
+        /**
+         * Move every ship along its velocity over the turn, resolving collisions
+         * in the order they happen: ships that touch are both destroyed, a ship
+         * hitting a planet deals its health to the planet, and a ship leaving the
+         * map is destroyed.
+         */
+        void move_ships(ForwardState& state) {
+            std::vector<ForwardState::ShipState>& ships = state.ships;
+            events.clear();
+            build_grid(state);
+
+            for (unsigned int i = 0; i < ships.size(); ++i) {
+                const Ship& ship = ships[i];
+                const Location& velocity = velocities[i];
+                const bool moving = velocity.pos_x != 0 || velocity.pos_y != 0;
+
+                if (moving) {
+                    const double leaves = exit_time(ship.location, velocity, state.map_width, state.map_height);
+                    if (leaves >= 0) {
+                        events.push_back({ leaves, i, 0, NONE });
+                    }
+                    for (unsigned int p = 0; p < state.planets.size(); ++p) {
+                        const ForwardState::PlanetState& planet = state.planets[p];
+                        const double time = contact_time(
+                                ship.location.pos_x - planet.location.pos_x, ship.location.pos_y - planet.location.pos_y,
+                                velocity.pos_x, velocity.pos_y, ship.radius + planet.radius);
+                        if (time >= 0) {
+                            events.push_back({ time, i, 1, p });
+                        }
+                    }
+                }
+
+                const double speed = std::sqrt(velocity.pos_x * velocity.pos_x + velocity.pos_y * velocity.pos_y);
+                for_each_nearby(ship.location, [&](const unsigned int j) {
+                    if (j <= i) {
+                        return;
+                    }
+                    const Ship& other = ships[j];
+                    const Location& other_velocity = velocities[j];
+                    if (!moving && other_velocity.pos_x == 0 && other_velocity.pos_y == 0) {
+                        return;
+                    }
+                    const double dx = other.location.pos_x - ship.location.pos_x;
+                    const double dy = other.location.pos_y - ship.location.pos_y;
+                    const double reach = ship.radius + other.radius + speed + constants::MAX_SPEED;
+                    if (std::abs(dx) > reach || std::abs(dy) > reach) {
+                        return;
+                    }
+                    const double time = contact_time(
+                            dx, dy, other_velocity.pos_x - velocity.pos_x, other_velocity.pos_y - velocity.pos_y,
+                            ship.radius + other.radius);
+                    if (time >= 0) {
+                        events.push_back({ time, i, 2, j });
+                    }
+                });
+            }
+
+            // Simultaneous events go in the order the ships, then the obstacles, are listed.
+            std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+                if (a.time != b.time) {
+                    return a.time < b.time;
+                }
+                if (a.ship != b.ship) {
+                    return a.ship < b.ship;
+                }
+                return a.kind != b.kind ? a.kind < b.kind : a.other < b.other;
+            });
+
+            for (const Event& event : events) {
+                Ship& ship = ships[event.ship];
+                if (!ship.is_alive()) {
+                    continue;
+                }
+                if (event.kind == 1) {
+                    ForwardState::PlanetState& planet = state.planets[event.other];
+                    if (!planet.is_alive()) {
+                        continue;
+                    }
+                    planet.health -= ship.health;
+                    ship.health = 0;
+                    if (!planet.is_alive()) {
+                        explode_planet(state, planet, event.time);
+                    }
+                } else if (event.kind == 0) {
+                    ship.health = 0;
+                } else if (ships[event.other].is_alive()) {
+                    ship.health = 0;
+                    ships[event.other].health = 0;
+                }
+            }
+
+            for (unsigned int i = 0; i < ships.size(); ++i) {
+                if (ships[i].is_alive()) {
+                    ships[i].location = position_at(ships[i], velocities[i], 1);
+                }
+            }
+        }
+
+        /**
+         * A destroyed planet takes its docked ships with it and damages every
+         * ship within EXPLOSION_RADIUS of its surface, from full health at the
+         * surface down to nothing at the edge of the blast.
+         */
+        void explode_planet(ForwardState& state, const ForwardState::PlanetState& planet, const double time) {
+            for (unsigned int i = 0; i < state.ships.size(); ++i) {
+                Ship& ship = state.ships[i];
+                if (!ship.is_alive()) {
+                    continue;
+                }
+                if (ship.docking_status != ShipDockingStatus::Undocked && ship.docked_planet == planet.entity_id) {
+                    ship.health = 0;
+                    continue;
+                }
+                const double distance = position_at(ship, velocities[i], time).get_distance_to(planet.location) - planet.radius;
+                if (distance < constants::EXPLOSION_RADIUS) {
+                    const double falloff = std::max(0.0, distance) / constants::EXPLOSION_RADIUS;
+                    ship.health -= static_cast<int>(std::ceil(constants::MAX_SHIP_HEALTH * (1 - falloff)));
+                }
+            }
+        }
+
+        /**
+         * Every undocked ship with its weapon ready splits WEAPON_DAMAGE evenly
+         * over the enemy ships in range at the end of movement. All damage is
+         * applied at once, so ships that die still fire this turn.
+         */
+        void resolve_combat(ForwardState& state) {
+            std::vector<ForwardState::ShipState>& ships = state.ships;
+            damage.assign(ships.size(), 0);
+            build_grid(state);
+
+            for (unsigned int i = 0; i < ships.size(); ++i) {
+                Ship& ship = ships[i];
+                if (ship.docking_status != ShipDockingStatus::Undocked || ship.weapon_cooldown > 0) {
+                    continue;
+                }
+                targets.clear();
+                for_each_nearby(ship.location, [&](const unsigned int j) {
+                    const Ship& other = ships[j];
+                    if (other.owner_id == ship.owner_id) {
+                        return;
+                    }
+                    const double reach = constants::WEAPON_RADIUS + ship.radius + other.radius;
+                    const double dx = other.location.pos_x - ship.location.pos_x;
+                    const double dy = other.location.pos_y - ship.location.pos_y;
+                    if (dx * dx + dy * dy <= reach * reach) {
+                        targets.push_back(j);
+                    }
+                });
+                if (targets.empty()) {
+                    continue;
+                }
+                for (const unsigned int target : targets) {
+                    damage[target] += constants::WEAPON_DAMAGE / static_cast<int>(targets.size());
+                }
+                ship.weapon_cooldown = constants::WEAPON_COOLDOWN;
+            }
+
+            for (unsigned int i = 0; i < ships.size(); ++i) {
+                ships[i].health -= damage[i];
+            }
+        }
+
+        static void update_docking(ForwardState& state) {
+            for (ForwardState::ShipState& ship : state.ships) {
+                if (ship.docking_status != ShipDockingStatus::Docking
+                    && ship.docking_status != ShipDockingStatus::Undocking) {
+                    continue;
+                }
+                if (--ship.docking_progress > 0) {
+                    continue;
+                }
+                ship.docking_progress = 0;
+                if (ship.docking_status == ShipDockingStatus::Docking) {
+                    ship.docking_status = ShipDockingStatus::Docked;
+                    continue;
+                }
+
+                ship.docking_status = ShipDockingStatus::Undocked;
+                ForwardState::PlanetState* planet = state.find_planet(ship.docked_planet);
+                ship.docked_planet = 0;
+                if (planet != nullptr && --planet->num_docked == 0) {
+                    release(*planet);
+                }
+            }
+        }
+
+        /// Docked ships mine their planet; every PRODUCTION_PER_SHIP units become a new ship.
+        void produce(ForwardState& state) {
+            docked_counts.assign(state.planets.size(), 0);
+            for (const ForwardState::ShipState& ship : state.ships) {
+                if (ship.docking_status == ShipDockingStatus::Docked) {
+                    if (const ForwardState::PlanetState* planet = state.find_planet(ship.docked_planet)) {
+                        ++docked_counts[planet - state.planets.data()];
+                    }
+                }
+            }
+
+            const size_t num_ships = state.ships.size();
+            bool grid_built = false;
+            for (size_t p = 0; p < state.planets.size(); ++p) {
+                ForwardState::PlanetState& planet = state.planets[p];
+                if (!planet.owned) {
+                    continue;
+                }
+                const int mined = std::min(static_cast<int>(docked_counts[p]) * constants::BASE_PRODUCTIVITY,
+                                           planet.remaining_production);
+                planet.remaining_production -= mined;
+                planet.current_production += mined;
+
+                if (planet.current_production >= constants::PRODUCTION_PER_SHIP && !grid_built) {
+                    build_grid(state);
+                    grid_built = true;
+                }
+                while (planet.current_production >= constants::PRODUCTION_PER_SHIP && spawn_ship(state, planet, num_ships)) {
+                    planet.current_production -= constants::PRODUCTION_PER_SHIP;
+                }
+            }
+            if (state.ships.size() != num_ships) {
+                // New ships have the highest ids, so this only moves them to the end of their owner's ships.
+                std::sort(state.ships.begin(), state.ships.end(), ForwardState::engine_order);
+            }
+        }
+
+        /**
+         * Place a new ship SPAWN_RADIUS off the planet's surface, on the side
+         * facing the map center or as close to it as there is free space. The
+         * first num_gridded ships are on the grid.
+         */
+        bool spawn_ship(ForwardState& state, const ForwardState::PlanetState& planet, const size_t num_gridded) {
+            const Location center = { state.map_width / 2.0, state.map_height / 2.0 };
+            const double base_angle = planet.location.orient_towards_in_rad(center);
+            const double distance = planet.radius + constants::SPAWN_RADIUS;
+            const double angle_step_rad = M_PI / 18;
+
+            for (int attempt = 0; attempt < SPAWN_ATTEMPTS; ++attempt) {
+                const int side = attempt % 2 == 0 ? 1 : -1;
+                const double angle = base_angle + side * ((attempt + 1) / 2) * angle_step_rad;
+                const Location location = {
+                        planet.location.pos_x + distance * std::cos(angle),
+                        planet.location.pos_y + distance * std::sin(angle),
+                };
+                const double radius = constants::SHIP_RADIUS;
+                bool free = location.pos_x >= radius && location.pos_x <= state.map_width - radius
+                            && location.pos_y >= radius && location.pos_y <= state.map_height - radius;
+                if (free) {
+                    for_each_nearby(location, [&](const unsigned int j) {
+                        const Ship& ship = state.ships[j];
+                        free = free && ship.location.get_distance_to(location) > ship.radius + radius;
+                    });
+                }
+                for (size_t j = num_gridded; j < state.ships.size(); ++j) {
+                    const Ship& ship = state.ships[j];
+                    free = free && ship.location.get_distance_to(location) > ship.radius + radius;
+                }
+                for (const ForwardState::PlanetState& other : state.planets) {
+                    free = free && other.location.get_distance_to(location) > other.radius + radius;
+                }
+                if (!free) {
+                    continue;
+                }
+
+                ForwardState::ShipState ship;
+                ship.entity_id = state.next_ship_id++;
+                ship.owner_id = planet.owner_id;
+                ship.location = location;
+                ship.health = constants::BASE_SHIP_HEALTH;
+                ship.radius = radius;
+                ship.weapon_cooldown = 0;
+                ship.docking_status = ShipDockingStatus::Undocked;
+                ship.docking_progress = 0;
+                ship.docked_planet = 0;
+                ship.dock_order = 0;
+                state.ships.push_back(ship);
+                return true;
+            }
+            return false;
+        }
+    };
+}
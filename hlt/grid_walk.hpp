@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "location.hpp"
+
+namespace hlt {
+    namespace grid_walk {
+        /**
+         * Walk the cells of a cols x rows grid of square cells crossed by a
+         * segment (Amanatides & Woo), visiting each cell id (y * cols + x)
+         * once. Cells off the grid are clamped onto its border, which holds
+         * everything that reaches past the edge. The visitor returns false to
+         * stop the walk.
+         */
+        template<typename CellVisitor>
+        static void for_each_cell_on_segment(
+                const Location& start,
+                const Location& end,
+                const double cell_size,
+                const int cols,
+                const int rows,
+                CellVisitor visit)
+        {
+            if (cols == 0) {
+                return;
+            }
+
+            const double inv_size = 1.0 / cell_size;
+            const double x0 = start.pos_x * inv_size;
+            const double y0 = start.pos_y * inv_size;
+            const double x1 = end.pos_x * inv_size;
+            const double y1 = end.pos_y * inv_size;
+
+            int cx = static_cast<int>(std::floor(x0));
+            int cy = static_cast<int>(std::floor(y0));
+            const int steps = std::abs(static_cast<int>(std::floor(x1)) - cx)
+                              + std::abs(static_cast<int>(std::floor(y1)) - cy);
+
+            const double dx = x1 - x0;
+            const double dy = y1 - y0;
+            const int step_x = dx > 0 ? 1 : -1;
+            const int step_y = dy > 0 ? 1 : -1;
+            const double t_delta_x = dx != 0 ? std::abs(1.0 / dx) : HUGE_VAL;
+            const double t_delta_y = dy != 0 ? std::abs(1.0 / dy) : HUGE_VAL;
+            double t_max_x = dx != 0 ? (step_x > 0 ? cx + 1 - x0 : x0 - cx) * t_delta_x : HUGE_VAL;
+            double t_max_y = dy != 0 ? (step_y > 0 ? cy + 1 - y0 : y0 - cy) * t_delta_y : HUGE_VAL;
+
+            int last_cell = -1;
+            for (int i = 0; ; ++i) {
+                const int cell = std::max(0, std::min(rows - 1, cy)) * cols + std::max(0, std::min(cols - 1, cx));
+                if (cell != last_cell && !visit(cell)) {
+                    return;
+                }
+                last_cell = cell;
+
+                if (i == steps) {
+                    return;
+                }
+                if (t_max_x < t_max_y) {
+                    cx += step_x;
+                    t_max_x += t_delta_x;
+                } else {
+                    cy += step_y;
+                    t_max_y += t_delta_y;
+                }
+            }
+        }
+    }
+}
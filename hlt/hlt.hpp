@@ -1,10 +1,12 @@
 #pragma once
 
+#include <cstdlib>
 #include <iostream>
 
 #include "log.hpp"
 #include "hlt_in.hpp"
 #include "hlt_out.hpp"
+#include "profile.hpp"
 
 namespace hlt {
     struct Metadata {
@@ -26,9 +28,16 @@ namespace hlt {
         iss2 >> map_width >> map_height;
 
         Log::open(std::to_string(player_id) + "_" + bot_name + ".log");
+        profile::Profiler::open(std::to_string(player_id) + "_" + bot_name + ".profile");
 
         in::setup(bot_name, map_width, map_height);
 
+        // HLT_RECORD=DIR records the game to DIR/<player id>_<bot name>.hltr, for halite_replay.
+        if (const char* record_dir = std::getenv("HLT_RECORD")) {
+            in::record(std::string(record_dir) + "/" + std::to_string(player_id) + "_" + bot_name + ".hltr",
+                       static_cast<PlayerId>(player_id));
+        }
+
         return {
                 static_cast<PlayerId>(player_id),
                 hlt::in::get_map()
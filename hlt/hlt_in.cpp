@@ -1,6 +1,9 @@
 #include "hlt_in.hpp"
 #include "log.hpp"
 #include "hlt_out.hpp"
+#include "replay.hpp"
+#include "turn_timer.hpp"
+#include "world.hpp"
 
 namespace hlt {
     namespace in {
@@ -9,32 +12,63 @@ namespace hlt {
         static int g_map_height;
         static int g_turn = 0;
 
+        /// Holds the current frame; keeps its capacity from turn to turn.
+        static std::string g_frame;
+
         void setup(const std::string& bot_name, int map_width, int map_height) {
             g_bot_name = bot_name;
             g_map_width = map_width;
             g_map_height = map_height;
         }
 
-        const Map get_map() {
+        bool record(const std::string& filename, const PlayerId player_id) {
+            replay::Header header;
+            header.player_id = player_id;
+            header.map_width = g_map_width;
+            header.map_height = g_map_height;
+            header.bot_name = g_bot_name;
+            if (!replay::Recorder::get().start(filename, header)) {
+                HLT_LOG(Warning, "cannot record to " << filename);
+                return false;
+            }
+            return true;
+        }
+
+        /// Read the next frame into g_frame, answering the engine and starting the turn clock.
+        static void read_frame() {
             if (g_turn == 1) {
+                HLT_LOG(Info, "pre-game time: " << TurnTimer::elapsed_ms() << " ms");
                 out::send_string(g_bot_name);
             }
 
-            const std::string input = get_string();
+            read_line(g_frame);
+            TurnTimer::start(g_turn == 0 ? constants::PREGAME_TIME_LIMIT_MS : constants::TURN_TIME_LIMIT_MS);
 
             if (!std::cin.good()) {
                 // This is needed on Windows to detect that game engine is done.
+                // std::exit() still runs this thread's Log destructor, which writes out the log.
                 std::exit(0);
             }
+            replay::Recorder::get().frame(g_frame);
 
             if (g_turn == 0) {
-                Log::log("--- PRE-GAME ---");
+                HLT_LOG(Info, "--- PRE-GAME ---");
             } else {
-                Log::log("--- TURN " + std::to_string(g_turn) + " ---");
+                HLT_LOG(Info, "--- TURN " << g_turn << " ---");
             }
             ++g_turn;
+        }
+
+        const Map get_map() {
+            read_frame();
+            return parse_map(g_frame, g_map_width, g_map_height);
+        }
 
-            return parse_map(input, g_map_width, g_map_height);
+        const World& get_world() {
+            static World world(g_map_width, g_map_height);
+            read_frame();
+            world.update(g_frame);
+            return world;
         }
     }
 }
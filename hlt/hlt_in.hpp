@@ -1,11 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 
 #include "map.hpp"
+#include "profile.hpp"
+#include "tokenizer.hpp"
 
 namespace hlt {
+    class World;
+
     namespace in {
         static std::string get_string() {
             std::string result;
@@ -13,6 +18,11 @@ namespace hlt {
             return result;
         }
 
+        /// Read one line into a caller-owned buffer, reusing its capacity.
+        static bool read_line(std::string& buffer) {
+            return static_cast<bool>(std::getline(std::cin, buffer));
+        }
+
         static std::pair<EntityId, Ship> parse_ship(std::stringstream& iss, const PlayerId owner_id) {
             Ship ship;
 
@@ -78,7 +88,8 @@ namespace hlt {
             return std::make_pair(planet.entity_id, planet);
         }
 
-        static Map parse_map(const std::string& input, const int map_width, const int map_height) {
+        /// Reference stringstream parser; parse_map() must produce the same Map.
+        static Map parse_map_stream(const std::string& input, const int map_width, const int map_height) {
             std::stringstream iss(input);
 
             int num_players;
@@ -120,7 +131,105 @@ namespace hlt {
             return map;
         }
 
+        static void parse_ship(Tokenizer& tokens, const PlayerId owner_id, Ship& ship) {
+            ship.entity_id = tokens.next_uint();
+            ship.location.pos_x = tokens.next_double();
+            ship.location.pos_y = tokens.next_double();
+            ship.health = tokens.next_int();
+
+            // No longer in the game, but still part of protocol.
+            tokens.next_double();
+            tokens.next_double();
+
+            ship.docking_status = static_cast<ShipDockingStatus>(tokens.next_int());
+            ship.docked_planet = tokens.next_uint();
+            ship.docking_progress = tokens.next_int();
+            ship.weapon_cooldown = tokens.next_int();
+
+            ship.owner_id = owner_id;
+            ship.radius = constants::SHIP_RADIUS;
+        }
+
+        static void parse_planet(Tokenizer& tokens, Planet& planet) {
+            planet.entity_id = tokens.next_uint();
+            planet.location.pos_x = tokens.next_double();
+            planet.location.pos_y = tokens.next_double();
+            planet.health = tokens.next_int();
+            planet.radius = tokens.next_double();
+            planet.docking_spots = tokens.next_uint();
+            planet.current_production = tokens.next_int();
+            planet.remaining_production = tokens.next_int();
+
+            planet.owned = tokens.next_int() == 1;
+            const int owner = tokens.next_int();
+            planet.owner_id = planet.owned ? static_cast<PlayerId>(owner) : -1;
+
+            const unsigned int num_docked_ships = tokens.next_uint();
+            if (num_docked_ships > planet.docked_ships.capacity()) {
+                // A planet that fills up then only allocates once.
+                planet.docked_ships.reserve(std::max(num_docked_ships, planet.docking_spots));
+            }
+            planet.docked_ships.resize(num_docked_ships);
+            for (unsigned int i = 0; i < num_docked_ships; ++i) {
+                planet.docked_ships[i] = tokens.next_uint();
+            }
+        }
+
+        /**
+         * Parse one turn frame in place. Fields are written straight into the
+         * Map's containers; no per-token strings or streams are created.
+         */
+        static Map parse_map(const char* input, const int map_width, const int map_height) {
+            HLT_PROFILE_SCOPE(Parse);
+            Tokenizer tokens(input);
+
+            const int num_players = tokens.next_int();
+
+            Map map = Map(map_width, map_height);
+
+            for (int i = 0; i < num_players; ++i) {
+                const PlayerId player_id = static_cast<PlayerId>(tokens.next_int());
+                const unsigned int num_ships = tokens.next_uint();
+
+                std::vector<Ship>& ship_vec = map.ships[player_id];
+                entity_map<unsigned int>& ship_map = map.ship_map[player_id];
+
+                ship_vec.resize(num_ships);
+                ship_map.reserve(num_ships);
+                for (unsigned int j = 0; j < num_ships; ++j) {
+                    parse_ship(tokens, player_id, ship_vec[j]);
+                    ship_map[ship_vec[j].entity_id] = j;
+                }
+            }
+
+            const unsigned int num_planets = tokens.next_uint();
+
+            map.planets.resize(num_planets);
+            map.planet_map.reserve(num_planets);
+            for (unsigned int i = 0; i < num_planets; ++i) {
+                parse_planet(tokens, map.planets[i]);
+                map.planet_map[map.planets[i].entity_id] = i;
+            }
+
+            return map;
+        }
+
+        static Map parse_map(const std::string& input, const int map_width, const int map_height) {
+            return parse_map(input.c_str(), map_width, map_height);
+        }
+
         void setup(const std::string& bot_name, int map_width, int map_height);
+
+        /**
+         * Record every frame read from here on, and the moves sent back, to
+         * filename (see replay.hpp). Call after setup(), before the pre-game
+         * frame is read.
+         */
+        bool record(const std::string& filename, PlayerId player_id);
+
         const Map get_map();
+
+        /// Read the next frame into the bot's persistent World and return it.
+        const World& get_world();
     }
 }
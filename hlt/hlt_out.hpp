@@ -1,21 +1,163 @@
 #pragma once
 
-#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #include "log.hpp"
 #include "move.hpp"
+#include "profile.hpp"
+#include "replay.hpp"
+#include "turn_timer.hpp"
 
 namespace hlt {
     namespace out {
+        /**
+         * Builds a turn's command line in the engine's wire format ("t id
+         * thrust angle ", "d id planet ", "u id ", then a newline) in a char
+         * buffer that keeps its capacity from turn to turn.
+         */
+        class MoveEncoder {
+        public:
+            void clear() {
+                used = 0;
+            }
+
+            void append(const Move& move) {
+                char* out = reserve(MAX_MOVE_CHARS);
+                switch (move.type) {
+                    case MoveType::Noop:
+                        return;
+                    case MoveType::Undock:
+                        *out++ = 'u';
+                        *out++ = ' ';
+                        out = put_uint(out, move.ship_id);
+                        break;
+                    case MoveType::Dock:
+                        *out++ = 'd';
+                        *out++ = ' ';
+                        out = put_uint(out, move.ship_id);
+                        *out++ = ' ';
+                        out = put_uint(out, move.dock_to);
+                        break;
+                    case MoveType::Thrust:
+                        *out++ = 't';
+                        *out++ = ' ';
+                        out = put_uint(out, move.ship_id);
+                        *out++ = ' ';
+                        out = put_int(out, move.move_thrust);
+                        *out++ = ' ';
+                        out = put_int(out, move.move_angle_deg);
+                        break;
+                }
+                *out++ = ' ';
+                used = static_cast<size_t>(out - buffer.data());
+            }
+
+            /// Encode a whole turn, newline included, replacing what the buffer held.
+            void encode(const std::vector<Move>& moves) {
+                clear();
+                for (const Move& move : moves) {
+                    append(move);
+                }
+                *reserve(1) = '\n';
+                ++used;
+            }
+
+            const char* data() const {
+                return buffer.data();
+            }
+
+            size_t size() const {
+                return used;
+            }
+
+        private:
+            // The command letter and a space, then up to three numbers of at most 11 characters and a space each.
+            static const size_t MAX_MOVE_CHARS = 2 + 3 * 12;
+
+            std::vector<char> buffer;
+            size_t used = 0;
+
+            char* reserve(const size_t count) {
+                if (buffer.size() < used + count) {
+                    buffer.resize(std::max(2 * buffer.size(), used + count));
+                }
+                return buffer.data() + used;
+            }
+
+            /// Decimal digits, two at a time from the lowest, through a lookup table.
+            static char* put_uint(char* out, unsigned int value) {
+                static const char PAIRS[] =
+                        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                        "8081828384858687888990919293949596979899";
+                char digits[10];
+                char* end = digits + sizeof(digits);
+                char* start = end;
+                while (value >= 100) {
+                    const unsigned int pair = value % 100;
+                    value /= 100;
+                    start -= 2;
+                    start[0] = PAIRS[2 * pair];
+                    start[1] = PAIRS[2 * pair + 1];
+                }
+                if (value >= 10) {
+                    start -= 2;
+                    start[0] = PAIRS[2 * value];
+                    start[1] = PAIRS[2 * value + 1];
+                } else {
+                    *--start = static_cast<char>('0' + value);
+                }
+                std::memcpy(out, start, static_cast<size_t>(end - start));
+                return out + (end - start);
+            }
+
+            static char* put_int(char* out, const int value) {
+                if (value < 0) {
+                    *out++ = '-';
+                    return put_uint(out, 0u - static_cast<unsigned int>(value));
+                }
+                return put_uint(out, static_cast<unsigned int>(value));
+            }
+        };
+
+        /// Write all of data to a file descriptor, retrying short writes.
+        static bool write_all(const int fd, const char* data, size_t size) {
+            while (size > 0) {
+#ifdef _WIN32
+                const int written = _write(fd, data, static_cast<unsigned int>(size));
+#else
+                const ssize_t written = ::write(fd, data, size);
+#endif
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+        }
+
         static bool send_string(const std::string& text) {
-            // note that std::endl flushes
-            std::cout << text << std::endl;
-            return std::cout.good();
+            const std::string line = text + '\n';
+            return write_all(1, line.data(), line.size());
         }
 
-        /// Send all queued moves to the game engine.
-        static bool send_moves(const std::vector<Move>& moves) {
+        /// Reference iostream encoder; MoveEncoder must produce the same line.
+        static std::string format_moves_stream(const std::vector<Move>& moves) {
             std::ostringstream oss;
             for (const Move& move : moves) {
                 switch (move.type) {
@@ -35,8 +177,21 @@ namespace hlt {
                         break;
                 }
             }
+            oss << '\n';
+            return oss.str();
+        }
+
+        /// Send all queued moves to the game engine, as one write.
+        static bool send_moves(const std::vector<Move>& moves) {
+            HLT_PROFILE_SCOPE(Output);
+            static thread_local MoveEncoder encoder;
+            encoder.encode(moves);
+            const bool sent = write_all(1, encoder.data(), encoder.size());
+            replay::Recorder::get().moves(encoder.data(), encoder.size());
+
+            HLT_LOG(Info, "turn time: " << TurnTimer::elapsed_ms() << " ms of " << TurnTimer::limit_ms() << " ms");
 
-            return send_string(oss.str());
+            return sent;
         }
     }
 }
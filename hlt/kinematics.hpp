@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cmath>
+
+#include "constants.hpp"
+#include "location.hpp"
+
+namespace hlt {
+    /**
+     * The engine's discrete move space: integer thrust 0..MAX_SPEED along
+     * integer headings 0..359 degrees. A thrust moves a ship by thrust times
+     * the heading's unit vector, which is what these functions look up
+     * instead of calling cos and sin for every candidate.
+     */
+    namespace kinematics {
+        static const int NUM_HEADINGS = 360;
+
+        struct Offset {
+            double dx, dy;
+        };
+
+        /**
+         * Unit vectors of every heading, computed the way the engine turns a
+         * command into a velocity, so lookups round exactly as it does.
+         * C++11 cannot evaluate cos and sin at compile time, so the table is
+         * filled on first use, see headings().
+         */
+        class HeadingTable {
+        public:
+            HeadingTable() {
+                for (int deg = 0; deg < NUM_HEADINGS; ++deg) {
+                    const double angle_rad = deg * M_PI / 180.0;
+                    units[deg] = { std::cos(angle_rad), std::sin(angle_rad) };
+                }
+            }
+
+            const Offset& operator[](const int deg) const {
+                return units[deg];
+            }
+
+        private:
+            Offset units[NUM_HEADINGS];
+        };
+
+        /**
+         * The one HeadingTable of the program. Built on first use rather than
+         * during static initialization, so it is already filled for code that
+         * runs in another unit's static initializer, and inline rather than
+         * static so every unit shares it.
+         */
+        inline const HeadingTable& headings() {
+            static const HeadingTable table;
+            return table;
+        }
+
+        /// Any integer number of degrees as a heading in [0, 360).
+        static int normalize_deg(const int angle_deg) {
+            const int deg = angle_deg % NUM_HEADINGS;
+            return deg < 0 ? deg + NUM_HEADINGS : deg;
+        }
+
+        static const Offset& unit(const int angle_deg) {
+            return headings()[normalize_deg(angle_deg)];
+        }
+
+        /// How far a thrust command moves a ship in one turn.
+        static Offset offset(const int thrust, const int angle_deg) {
+            const Offset& heading = unit(angle_deg);
+            return { thrust * heading.dx, thrust * heading.dy };
+        }
+
+        /// Where a ship at start ends the turn after a thrust command, obstacles aside.
+        static Location endpoint(const Location& start, const int thrust, const int angle_deg) {
+            const Offset& heading = unit(angle_deg);
+            return { start.pos_x + thrust * heading.dx, start.pos_y + thrust * heading.dy };
+        }
+    }
+}
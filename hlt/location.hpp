@@ -26,14 +26,18 @@ namespace hlt {
             return std::atan2(dy, dx) + 2 * M_PI;
         }
 
+        /// The point MIN_DISTANCE_FOR_CLOSEST_POINT off the target's surface, on the side facing this location.
         Location get_closest_point(const Location& target, const double target_radius) const {
             const double radius = target_radius + constants::MIN_DISTANCE_FOR_CLOSEST_POINT;
-            const double angle_rad = target.orient_towards_in_rad(*this);
-
-            const double x = target.pos_x + radius * std::cos(angle_rad);
-            const double y = target.pos_y + radius * std::sin(angle_rad);
+            const double dx = pos_x - target.pos_x;
+            const double dy = pos_y - target.pos_y;
+            const double distance = std::sqrt(dx*dx + dy*dy);
+            if (distance == 0) {
+                return { target.pos_x + radius, target.pos_y };
+            }
 
-            return { x, y };
+            // Along the unit vector from the target to here, rather than via its angle.
+            return { target.pos_x + radius * dx / distance, target.pos_y + radius * dy / distance };
         }
 
         friend std::ostream& operator<<(std::ostream& out, const Location& location);
@@ -1,30 +1,309 @@
 #pragma once
 
-#include <fstream>
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
 #include <string>
+#include <thread>
+#include <vector>
 
-namespace hlt {
-    struct Log {
-    private:
-        std::ofstream file;
+/**
+ * Messages below this level are compiled out of HLT_LOG: 0 keeps debug
+ * messages, 1 (the default) starts at info, 4 drops everything.
+ */
+#ifndef HLT_LOG_LEVEL
+#define HLT_LOG_LEVEL 1
+#endif
 
-        void initialize(const std::string& filename) {
-            file.open(filename, std::ios::trunc | std::ios::out);
-        }
+/**
+ * Log a message built with <<, e.g. HLT_LOG(Debug, "ship " << id). Below
+ * HLT_LOG_LEVEL the statement compiles to nothing, and with no log file
+ * open the message is not formatted.
+ */
+#define HLT_LOG(level, message)                                                     \
+    do {                                                                            \
+        if (::hlt::Log::compiled(::hlt::LogLevel::level) && ::hlt::Log::enabled()) { \
+            ::hlt::Log::begin_line() << message;                                    \
+            ::hlt::Log::end_line();                                                 \
+        }                                                                           \
+    } while (false)
 
+namespace hlt {
+    enum class LogLevel {
+        Debug = 0,
+        Info,
+        Warning,
+        Error,
+    };
+
+    /**
+     * Per-thread log file; a thread that never calls open() logs nothing.
+     *
+     * Logging only copies the line into a ring buffer, without locks or
+     * system calls; a background thread writes the buffer out every 20
+     * milliseconds, or sooner once it is half full. Lines that do not fit
+     * are dropped and counted rather than holding up the turn.
+     *
+     * Everything logged is written out when the thread ends, including on
+     * std::exit() from the logging thread, or on flush().
+     */
+    class Log {
     public:
         static Log& get() {
-            static Log instance{};
+            static thread_local Log instance{};
             return instance;
         }
 
         static void open(const std::string& filename) {
-            get().initialize(filename);
+            get().start(filename);
+        }
+
+        static constexpr bool compiled(const LogLevel level) {
+            return static_cast<int>(level) >= HLT_LOG_LEVEL;
+        }
+
+        /// Whether this thread's messages go anywhere, so callers can skip formatting them.
+        static bool enabled() {
+            return get().file != nullptr;
+        }
+
+        static void log(const LogLevel level, const std::string& message) {
+            if (compiled(level)) {
+                get().push(message.data(), message.size());
+            }
         }
 
         static void log(const std::string& message) {
-            get().file << message << std::endl;
+            log(LogLevel::Info, message);
+        }
+
+        /// A stream for one line, with default formatting; end_line() logs it.
+        static std::ostream& begin_line() {
+            Log& log = get();
+            log.line_buffer.clear();
+            log.line_stream.clear();
+            log.line_stream.flags(std::ios_base::dec | std::ios_base::skipws);
+            log.line_stream.precision(6);
+            log.line_stream.fill(' ');
+            return log.line_stream;
+        }
+
+        static void end_line() {
+            Log& log = get();
+            log.push(log.line_buffer.data(), log.line_buffer.size());
+        }
+
+        /// Write out everything logged so far on this thread.
+        static void flush() {
+            Log& log = get();
+            log.drain();
+            log.write_dropped_notice();
+        }
+
+        Log() : line_stream(&line_buffer) {
+        }
+
+        Log(const Log&) = delete;
+        Log& operator=(const Log&) = delete;
+
+        ~Log() {
+            stop();
+        }
+
+    private:
+        static const size_t RING_BYTES = 1 << 20;
+
+        /// Characters of the line being formatted, kept between lines so formatting does not allocate.
+        class LineBuffer : public std::streambuf {
+        public:
+            void clear() {
+                chars.clear();
+            }
+
+            const char* data() const {
+                return chars.data();
+            }
+
+            size_t size() const {
+                return chars.size();
+            }
+
+        protected:
+            int_type overflow(const int_type c) override {
+                if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                    chars.push_back(traits_type::to_char_type(c));
+                }
+                return traits_type::not_eof(c);
+            }
+
+            std::streamsize xsputn(const char* s, const std::streamsize count) override {
+                chars.insert(chars.end(), s, s + count);
+                return count;
+            }
+
+        private:
+            std::vector<char> chars;
+        };
+
+        LineBuffer line_buffer;
+        std::ostream line_stream;
+
+        std::FILE* file = nullptr;
+
+        // Single producer (the owning thread), single consumer (whoever holds drain_mutex).
+        std::unique_ptr<char[]> ring;
+        std::atomic<size_t> head{ 0 };
+        std::atomic<size_t> tail{ 0 };
+        size_t dropped = 0;
+
+        std::thread flusher;
+        std::mutex drain_mutex;
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        /// Set with the flusher woken early, so it drains now rather than waiting out its 20 ms.
+        bool pending = false;
+        bool stopping = false;
+
+        void start(const std::string& filename) {
+            stop();
+            file = std::fopen(filename.c_str(), "w");
+            if (file == nullptr) {
+                return;
+            }
+            ring.reset(new char[RING_BYTES]);
+            head = 0;
+            tail = 0;
+            dropped = 0;
+            pending = false;
+            stopping = false;
+            flusher = std::thread([this]() { flush_periodically(); });
+        }
+
+        void stop() {
+            if (file == nullptr) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            flusher.join();
+            drain();
+            write_dropped_notice();
+            std::fclose(file);
+            file = nullptr;
+        }
+
+        void push(const char* message, const size_t size) {
+            if (file == nullptr) {
+                return;
+            }
+            if (dropped > 0) {
+                char notice[64];
+                const int length = std::snprintf(notice, sizeof(notice), "[log: %zu messages dropped]", dropped);
+                if (!append_line(notice, static_cast<size_t>(length))) {
+                    ++dropped;
+                    return;
+                }
+                dropped = 0;
+            }
+            if (!append_line(message, size)) {
+                ++dropped;
+            }
+        }
+
+        /// Copy message and a newline into the ring if both fit.
+        bool append_line(const char* message, const size_t size) {
+            const size_t write_at = head.load(std::memory_order_relaxed);
+            const size_t read_at = tail.load(std::memory_order_acquire);
+            const size_t free_bytes = RING_BYTES - (write_at - read_at);
+            if (size + 1 > free_bytes) {
+                wake_flusher();
+                return false;
+            }
+
+            copy_in(write_at, message, size);
+            copy_in(write_at + size, "\n", 1);
+            head.store(write_at + size + 1, std::memory_order_release);
+
+            if (write_at + size + 1 - read_at > RING_BYTES / 2) {
+                wake_flusher();
+            }
+            return true;
+        }
+
+        void wake_flusher() {
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex);
+                pending = true;
+            }
+            wake.notify_one();
+        }
+
+        /**
+         * Mark the lines dropped since the last push(), which would otherwise
+         * only be reported by the next one. Runs on the owning thread after a
+         * drain(), so the notice lands after everything logged before it.
+         */
+        void write_dropped_notice() {
+            if (file == nullptr || dropped == 0) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(drain_mutex);
+            std::fprintf(file, "[log: %zu messages dropped]\n", dropped);
+            std::fflush(file);
+            dropped = 0;
+        }
+
+        void copy_in(const size_t position, const char* data, const size_t size) {
+            const size_t offset = position % RING_BYTES;
+            const size_t first = std::min(size, RING_BYTES - offset);
+            std::copy(data, data + first, ring.get() + offset);
+            std::copy(data + first, data + size, ring.get());
+        }
+
+        /// Write out whatever is in the ring.
+        void drain() {
+            if (file == nullptr) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(drain_mutex);
+            size_t read_at = tail.load(std::memory_order_relaxed);
+            const size_t write_at = head.load(std::memory_order_acquire);
+            if (read_at == write_at) {
+                return;
+            }
+            while (read_at != write_at) {
+                const size_t offset = read_at % RING_BYTES;
+                const size_t size = std::min(write_at - read_at, RING_BYTES - offset);
+                std::fwrite(ring.get() + offset, 1, size, file);
+                read_at += size;
+            }
+            tail.store(read_at, std::memory_order_release);
+            std::fflush(file);
+        }
+
+        void flush_periodically() {
+            for (;;) {
+                bool stop_now;
+                {
+                    std::unique_lock<std::mutex> lock(wake_mutex);
+                    wake.wait_for(lock, std::chrono::milliseconds(20), [this]() { return stopping || pending; });
+                    pending = false;
+                    stop_now = stopping;
+                }
+                drain();
+                if (stop_now) {
+                    return;
+                }
+            }
         }
     };
 }
@@ -1,6 +1,13 @@
 #include "map.hpp"
 
+#include <atomic>
+
 namespace hlt {
-    Map::Map(const int width, const int height) : map_width(width), map_height(height) {
+    Map::Map(const int width, const int height) : map_width(width), map_height(height), generation(next_generation()) {
+    }
+
+    unsigned long Map::next_generation() {
+        static std::atomic<unsigned long> last(0);
+        return ++last;
     }
 }
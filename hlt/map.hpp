@@ -16,8 +16,18 @@ namespace hlt {
         std::vector<Planet> planets;
         entity_map<unsigned int> planet_map;
 
+        /**
+         * Unique to these contents: a new Map gets a new one, and so does a
+         * Map updated in place for the next turn, so caches keyed on a Map
+         * can tell turns apart even when the object stays the same.
+         */
+        unsigned long generation;
+
         Map(int width, int height);
 
+        /// A generation no Map has had before; safe to call from any thread.
+        static unsigned long next_generation();
+
         const Ship& get_ship(const PlayerId player_id, const EntityId ship_id) const {
             return ships.at(player_id).at(ship_map.at(player_id).at(ship_id));
         }
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "constants.hpp"
+#include "flow_field.hpp"
+#include "navigation.hpp"
+#include "visibility_graph.hpp"
+#include "worker_pool.hpp"
+
+namespace hlt {
+    /**
+     * Plans the thrusts of all our ships for one turn together instead of one
+     * ship at a time as the strategy walks them.
+     *
+     * Each ship asks for a list of targets in order of preference. Requests
+     * are then resolved by priority: a ship takes the first of its targets
+     * that it can reach without hitting an obstacle or the path of a ship
+     * planned before it, and its own path is reserved in turn. Ships that find
+     * no free path stay put, which every later path already avoids.
+     *
+     * Requests live in numbered slots (normally one per ship), so they can be
+     * filled from several threads as long as each slot is filled by one. With
+     * a WorkerPool, plan() also works out the obstacle-free headings of every
+     * ship in parallel; reservations are always committed on the calling
+     * thread in slot order, so the moves are the same for any pool size
+     * (as long as the turn budget does not run low part way through).
+     *
+     * Given a VisibilityGraph, a ship whose way to a target is blocked by a
+     * planet heads for the first corner of the shortest path around it
+     * instead, and the sweep only has other ships left to steer around.
+     * Given FlowFields, ships headed for a planet follow its field until
+     * they are close, so they share one search however many there are;
+     * other targets may come with a field of their own.
+     *
+     * The planner keeps its buffers between turns; keep one per bot.
+     */
+    class MovePlanner {
+    public:
+        explicit MovePlanner(std::shared_ptr<WorkerPool> workers = nullptr) : workers(std::move(workers)) {
+        }
+
+        /// Route ships around planets along graph from now on; nullptr goes back to steering only.
+        void set_routes(std::shared_ptr<const VisibilityGraph> graph) {
+            routes = std::move(graph);
+        }
+
+        /// Steer ships headed for planets along fields from now on; nullptr goes back to routes or steering.
+        void set_flow_fields(std::shared_ptr<const FlowFields> fields) {
+            flows = std::move(fields);
+        }
+
+        /// Drop all requests and make room for slots [0, num_slots).
+        void reset(const size_t num_slots) {
+            requests.assign(num_slots, Request());
+        }
+
+        /**
+         * Ask for a move for ship. Lower priorities are planned first, and
+         * requests of equal priority in slot order.
+         */
+        void request(const size_t slot, const Ship& ship, const int priority) {
+            Request& request = requests[slot];
+            request.ship = &ship;
+            request.priority = priority;
+            request.num_targets = 0;
+        }
+
+        /// Withdraw the slot's request, e.g. because the ship got another command.
+        void cancel(const size_t slot) {
+            requests[slot] = Request();
+        }
+
+        /// Add a place the slot's ship may head for, with thrust up to max_thrust.
+        void add_target(const size_t slot, const Location& location, const int max_thrust) {
+            Request& request = requests[slot];
+            if (request.num_targets < constants::MAX_PLANNED_TARGETS) {
+                request.targets[request.num_targets++] = { location, max_thrust, nullptr };
+            }
+        }
+
+        /// Add the point next to entity that the slot's ship should dock or attack from.
+        void add_dock_target(const size_t slot, const Entity& entity, const int max_thrust) {
+            const Ship& ship = *requests[slot].ship;
+            add_target(slot, ship.location.get_closest_point(entity.location, entity.radius), max_thrust);
+        }
+
+        /// Add the point next to planet that the slot's ship should dock from, reached along its flow field.
+        void add_dock_target(const size_t slot, const Planet& planet, const int max_thrust) {
+            add_dock_target(slot, planet, max_thrust, flows ? flows->planet(planet.entity_id) : nullptr);
+        }
+
+        /// Add the point next to entity that the slot's ship should dock or attack from, reached along field if not nullptr.
+        void add_dock_target(const size_t slot, const Entity& entity, const int max_thrust, const FlowField* field) {
+            Request& request = requests[slot];
+            const int before = request.num_targets;
+            add_dock_target(slot, entity, max_thrust);
+            if (request.num_targets > before) {
+                request.targets[before].field = field;
+            }
+        }
+
+        /// Whether the slot's ship can take more targets.
+        bool wants_targets(const size_t slot) const {
+            return requests[slot].num_targets < constants::MAX_PLANNED_TARGETS;
+        }
+
+        /**
+         * Resolve every request and append the resulting moves. Reserves paths
+         * through navigation, so navigation::begin_turn(map) must have been
+         * called this turn on the calling thread.
+         */
+        void plan(const Map& map, std::vector<Move>& moves) {
+            order.clear();
+            for (unsigned int i = 0; i < requests.size(); ++i) {
+                if (requests[i].ship != nullptr && requests[i].num_targets > 0) {
+                    order.push_back(i);
+                }
+            }
+            // Ties go by slot; with that key a plain sort is stable, and unlike
+            // std::stable_sort it needs no temporary buffer.
+            std::sort(order.begin(), order.end(), [this](const unsigned int a, const unsigned int b) {
+                return requests[a].priority < requests[b].priority
+                       || (requests[a].priority == requests[b].priority && a < b);
+            });
+
+            // Headings towards each ship's first target, which is usually the one it takes.
+            const TurnBudget budget = TurnTimer::budget();
+            const SpatialIndex* index = &navigation::obstacle_index;
+            if (sweeps.size() < order.size()) {
+                sweeps.resize(order.size());
+            }
+            aims.resize(order.size());
+            const auto prepare = [&](const size_t i) {
+                const Request& request = requests[order[i]];
+                aims[i] = aim(*request.ship, request.targets[0]);
+                navigation::prepare_sweep(map, index, *request.ship, aims[i],
+                                          request.targets[0].max_thrust, constants::MAX_NAVIGATION_CORRECTIONS,
+                                          ANGULAR_STEP_RAD, budget, sweeps[i]);
+            };
+            if (workers) {
+                workers->run(order.size(), prepare);
+            } else {
+                for (size_t i = 0; i < order.size(); ++i) {
+                    prepare(i);
+                }
+            }
+
+            for (size_t i = 0; i < order.size(); ++i) {
+                if (TurnTimer::budget() == TurnBudget::Exhausted) {
+                    break;
+                }
+                const Request& request = requests[order[i]];
+                for (int t = 0; t < request.num_targets; ++t) {
+                    const Target& target = request.targets[t];
+                    if (t > 0) {
+                        aims[i] = aim(*request.ship, target);
+                        navigation::prepare_sweep(map, index, *request.ship, aims[i], target.max_thrust,
+                                                  constants::MAX_NAVIGATION_CORRECTIONS, ANGULAR_STEP_RAD,
+                                                  TurnTimer::budget(), sweeps[i]);
+                    }
+                    const possibly<Move> move = navigation::commit_sweep(
+                            map, *request.ship, aims[i], constants::MAX_NAVIGATION_CORRECTIONS,
+                            ANGULAR_STEP_RAD, sweeps[i]);
+                    if (move.second) {
+                        moves.push_back(move.first);
+                        break;
+                    }
+                }
+            }
+
+            requests.clear();
+        }
+
+    private:
+        static constexpr double ANGULAR_STEP_RAD = M_PI / 180.0;
+        /// How far past a full thrust aims are set, so rounding cannot take the thrust below it.
+        static constexpr double AIM_SLACK = 0.5;
+        /// Ships this close to a target with a flow field head straight for it; the grid is too coarse for docking.
+        static constexpr double FLOW_HANDOFF_DISTANCE = 2 * constants::MAX_SPEED;
+
+        struct Target {
+            Location location;
+            int max_thrust;
+            /// The flow field leading to the target, if any.
+            const FlowField* field;
+        };
+
+        struct Request {
+            const Ship* ship = nullptr;
+            int priority = 0;
+            int num_targets = 0;
+            Target targets[constants::MAX_PLANNED_TARGETS];
+        };
+
+        std::shared_ptr<WorkerPool> workers;
+        std::shared_ptr<const VisibilityGraph> routes;
+        std::shared_ptr<const FlowFields> flows;
+        std::vector<Request> requests;
+        std::vector<unsigned int> order;
+        std::vector<navigation::Sweep> sweeps;
+        /// Where each ship in order steers for its current target.
+        std::vector<Location> aims;
+
+        /**
+         * Where ship should steer to get to target: one thrust down the
+         * target's flow field, the target itself, or the first corner on the
+         * way around the planets. A corner closer than a
+         * full thrust is aimed past, along the same heading, rather than
+         * stopped at; going straight on from it only leads away from the
+         * planet it goes around.
+         */
+        Location aim(const Ship& ship, const Target& target) const {
+            if (flows && target.field != nullptr
+                && ship.location.get_distance_to(target.location) > FLOW_HANDOFF_DISTANCE) {
+                const possibly<Location> along = flows->aim(*target.field, ship.location, target.max_thrust + AIM_SLACK);
+                if (along.second) {
+                    return along.first;
+                }
+            }
+            if (!routes) {
+                return target.location;
+            }
+            const Location waypoint = routes->first_waypoint(ship.location, target.location);
+            if (waypoint == target.location) {
+                return waypoint;
+            }
+            const double distance = ship.location.get_distance_to(waypoint);
+            if (distance >= target.max_thrust || distance == 0) {
+                return waypoint;
+            }
+            const double scale = (target.max_thrust + AIM_SLACK) / distance;
+            return { ship.location.pos_x + (waypoint.pos_x - ship.location.pos_x) * scale,
+                     ship.location.pos_y + (waypoint.pos_y - ship.location.pos_y) * scale };
+        }
+    };
+}
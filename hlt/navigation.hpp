@@ -1,22 +1,50 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include "collision.hpp"
+#include "entity_store.hpp"
+#include "kinematics.hpp"
+#include "log.hpp"
 #include "map.hpp"
 #include "move.hpp"
+#include "planet_grid.hpp"
+#include "profile.hpp"
+#include "reservations.hpp"
+#include "spatial_index.hpp"
+#include "turn_timer.hpp"
 #include "util.hpp"
 
 namespace hlt {
     namespace navigation {
         
-        static std::vector<Location> intended_locations;
+        // Per-turn navigation state is per thread, so games can be played in parallel in one process.
+
+        /// Paths our ships have already been given this turn.
+        static thread_local Reservations reservations;
+
+        /// Where the planets are; outlives turns, since it only changes when a planet is destroyed.
+        static thread_local PlanetGrid planet_grid;
+
+        /// Obstacle grid for the current turn, see begin_turn().
+        static thread_local SpatialIndex obstacle_index;
+
+        /**
+         * Reset per-turn navigation state and index the obstacles of this
+         * turn's map. Navigation falls back to scanning the whole map for any
+         * map the index was not built from.
+         */
+        static void begin_turn(const Map& map) {
+            reservations.clear(map.map_width, map.map_height);
+            planet_grid.update(map);
+            obstacle_index.build(map, &planet_grid);
+        }
         
-        static bool there_will_be_my_ship_at(Location &want_to_go) {
-            for(Location loc : intended_locations) {
-                if(loc.get_distance_to(want_to_go) < constants::FORECAST_FUDGE_FACTOR ) {
-                    return true;
-                }
-            }
-            return false;
+        /// Whether moving from start to want_to_go would run into a ship we already moved this turn.
+        static bool there_will_be_my_ship_at(const Location& start, const Location& want_to_go) {
+            return reservations.conflicts(start, want_to_go);
         }
         
         static bool is_in_map(const Map &map, const Location location) {
@@ -24,29 +52,31 @@ namespace hlt {
             && 0 <= location.pos_y && location.pos_y < map.map_height;
         }
         
-        static Location toLocation(const Location &start, const int thrust, const int rad) {
-            Location result;
-            result.pos_x = start.pos_x + (thrust * cos(rad));
-            result.pos_y = start.pos_y + (thrust * sin(rad));
-            return result;
+        /// Where a thrust of thrust along angle_deg takes a ship from start; see kinematics::endpoint().
+        static Location toLocation(const Location &start, const int thrust, const int angle_deg) {
+            return kinematics::endpoint(start, thrust, angle_deg);
         }
         
+        /// Whether entity is in the way from start to target, ignoring entities centered on either end.
+        static bool is_between(const Location& start, const Location& target, const Entity& entity) {
+            const Location &location = entity.location;
+            return !(location == start || location == target)
+                   && collision::segment_circle_intersect(start, target, entity, constants::FORECAST_FUDGE_FACTOR);
+        }
+
         static void check_and_add_entity_between(
                 std::vector<const Entity *>& entities_found,
                 const Location& start,
                 const Location& target,
                 const Entity& entity_to_check)
         {
-            const Location &location = entity_to_check.location;
-            if (location == start || location == target) {
-                return;
-            }
-            if (collision::segment_circle_intersect(start, target, entity_to_check, constants::FORECAST_FUDGE_FACTOR)) {
+            if (is_between(start, target, entity_to_check)) {
                 entities_found.push_back(&entity_to_check);
             }
         }
 
         static std::vector<const Entity *> objects_between(const Map& map, const Location& start, const Location& target) {
+            HLT_PROFILE_COUNT(ObstacleQueries, 1);
             std::vector<const Entity *> entities_found;
 
             for (const Planet& planet : map.planets) {
@@ -62,6 +92,56 @@ namespace hlt {
             return entities_found;
         }
 
+        /// Batched scan over the store's columns; same result as !objects_between(...).empty().
+        static bool any_object_between(const EntityStore& entities, const Location& start, const Location& target) {
+            HLT_PROFILE_COUNT(ObstacleQueries, 1);
+            const size_t count = entities.size();
+            size_t slot = 0;
+            for (;;) {
+                slot = collision::segment_circles_first_hit(
+                        start, target, entities.pos_x.data(), entities.pos_y.data(), entities.radius.data(),
+                        count, constants::FORECAST_FUDGE_FACTOR, slot);
+                if (slot == count) {
+                    return false;
+                }
+                const Location location = { entities.pos_x[slot], entities.pos_y[slot] };
+                if (!(location == start || location == target)) {
+                    return true;
+                }
+                ++slot;
+            }
+        }
+
+        /// Uses index when it was built from map, and scans the whole map otherwise.
+        static bool any_object_between(
+                const Map& map,
+                const SpatialIndex* index,
+                const Location& start,
+                const Location& target)
+        {
+            HLT_PROFILE_COUNT(ObstacleQueries, 1);
+            if (index != nullptr && index->is_built_for(map)) {
+                return index->any_between(start, target);
+            }
+            for (const Planet& planet : map.planets) {
+                if (is_between(start, target, planet)) {
+                    return true;
+                }
+            }
+            for (const auto& player_ship : map.ships) {
+                for (const Ship& ship : player_ship.second) {
+                    if (is_between(start, target, ship)) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        static bool any_object_between(const Map& map, const Location& start, const Location& target) {
+            return any_object_between(map, &obstacle_index, start, target);
+        }
+
         static possibly<Move> navigate_ship_towards_target(
                 const Map& map,
                 const Ship& ship,
@@ -71,7 +151,8 @@ namespace hlt {
                 const int max_corrections,
                 const double angular_step_rad)
         {
-            if (max_corrections <= 0) {
+            HLT_PROFILE_SCOPE(Navigation);
+            if (max_corrections <= 0 || TurnTimer::budget() == TurnBudget::Exhausted) {
                 return { Move::noop(), false };
             }
 
@@ -89,13 +170,13 @@ namespace hlt {
             const int angle_deg = util::angle_rad_to_deg_clipped(angle_rad);
             Location result = toLocation(ship.location, thrust, angle_deg);
 
-            if (avoid_obstacles && (!objects_between(map, ship.location, target).empty()
-                || !is_in_map(map, result) || there_will_be_my_ship_at(result))) {
-                if(there_will_be_my_ship_at(result)) {
-                    std::ostringstream str;
-                    str << "THERE WILL BE MY SHIP: " << ship.entity_id << " LOCATION: " << ship.location;
-                    Log::log(str.str());
+            const bool my_ship_there = there_will_be_my_ship_at(ship.location, result);
+            if (avoid_obstacles && (any_object_between(map, ship.location, target)
+                || !is_in_map(map, result) || my_ship_there)) {
+                if(my_ship_there) {
+                    HLT_LOG(Debug, "THERE WILL BE MY SHIP: " << ship.entity_id << " LOCATION: " << ship.location);
                 }
+                HLT_PROFILE_COUNT(Corrections, 1);
                 const double new_target_dx = cos(angle_rad + angular_step_rad) * distance;
                 const double new_target_dy = sin(angle_rad + angular_step_rad) * distance;
                 const Location new_target = { ship.location.pos_x + new_target_dx, ship.location.pos_y + new_target_dy };
@@ -104,11 +185,305 @@ namespace hlt {
                         map, ship, new_target, max_thrust, true, (max_corrections - 1), angular_step_rad);
             }
             
-            intended_locations.push_back(result);
+            reservations.reserve(ship.location, result);
             
             return { Move::thrust(ship.entity_id, thrust, angle_deg), true };
         }
 
+        /// Map an angle within a few turns of zero into [-pi, pi).
+        static double wrap_angle_rad(double angle_rad) {
+            while (angle_rad >= M_PI) {
+                angle_rad -= 2 * M_PI;
+            }
+            while (angle_rad < -M_PI) {
+                angle_rad += 2 * M_PI;
+            }
+            return angle_rad;
+        }
+
+        /**
+         * The candidate headings base + k * step for |k| < size, and how many
+         * obstacles block each one. Blocked ranges are accumulated in a
+         * difference array, so adding an obstacle is O(1). The array is the
+         * caller's, so that fans built one after another share its storage.
+         */
+        class HeadingFan {
+        public:
+            HeadingFan(const double base_angle_rad, const double step_rad, const int size, std::vector<int>& coverage) :
+                    base_angle_rad(base_angle_rad), step_rad(step_rad), size(size), coverage(coverage)
+            {
+                coverage.assign(static_cast<size_t>(2 * size + 1), 0);
+            }
+
+            /**
+             * Block the headings from start along which a segment of the given
+             * length passes within reach of center. Matches
+             * collision::segment_circle_intersect up to a tiny safety margin.
+             */
+            void block(const Location& start, const double length, const Location& center, const double reach) {
+                const double dx = center.pos_x - start.pos_x;
+                const double dy = center.pos_y - start.pos_y;
+                const double squared_distance = dx * dx + dy * dy;
+                if (squared_distance > (length + reach) * (length + reach)) {
+                    return;
+                }
+                const double distance = std::sqrt(squared_distance);
+
+                double half_width;
+                if (distance <= reach) {
+                    // Already overlapping: anything not heading away from it hits.
+                    half_width = M_PI / 2;
+                } else if (length * length >= squared_distance - reach * reach) {
+                    // Long enough to reach the tangent points.
+                    half_width = std::asin(reach / distance);
+                } else if (length >= distance - reach) {
+                    // Only the end of the segment can get close enough.
+                    const double cos_width = (squared_distance + length * length - reach * reach) / (2 * distance * length);
+                    half_width = std::acos(std::min(1.0, cos_width));
+                } else {
+                    return;
+                }
+                half_width += 1e-9;
+
+                const double offset = wrap_angle_rad(std::atan2(dy, dx) - base_angle_rad);
+                block_range(offset - half_width, offset + half_width);
+                block_range(offset - half_width - 2 * M_PI, offset + half_width - 2 * M_PI);
+                block_range(offset - half_width + 2 * M_PI, offset + half_width + 2 * M_PI);
+            }
+
+            /// Turn the difference array into per-heading counts. Call once, after all block() calls.
+            void finish() {
+                for (size_t i = 1; i < coverage.size(); ++i) {
+                    coverage[i] += coverage[i - 1];
+                }
+            }
+
+            bool is_blocked(const int k) const {
+                return coverage[k + size - 1] > 0;
+            }
+
+            double angle_rad(const int k) const {
+                return base_angle_rad + k * step_rad;
+            }
+
+        private:
+            double base_angle_rad;
+            double step_rad;
+            int size;
+            std::vector<int>& coverage;
+
+            void block_range(const double from, const double to) {
+                const double limit = size - 1;
+                const double k_from = std::max(-limit, std::ceil(from / step_rad));
+                const double k_to = std::min(limit, std::floor(to / step_rad));
+                if (k_from > k_to) {
+                    return;
+                }
+                ++coverage[static_cast<int>(k_from) + size - 1];
+                --coverage[static_cast<int>(k_to) + size];
+            }
+        };
+
+        /**
+         * The headings a ship may take towards a target as far as obstacles and
+         * the map edge are concerned, in the order to try them. Our own ships'
+         * paths for this turn are left to commit_sweep().
+         */
+        struct Sweep {
+            int thrust = 0;
+            std::vector<int> angles_deg;
+            /// False while angles_deg only holds the direct heading and the fan has not been built.
+            bool complete = true;
+            /// Scratch for the HeadingFan.
+            std::vector<int> coverage;
+        };
+
+        /**
+         * Fill sweep with the free headings of every correction, found without
+         * trial and error: the headings blocked by obstacles are computed in one
+         * pass, so this costs O(obstacles + corrections) instead of a full
+         * obstacle scan per correction.
+         */
+        static void sweep_fan(
+                const Map& map,
+                const SpatialIndex* index,
+                const Ship& ship,
+                const Location& target,
+                const int max_corrections,
+                const double angular_step_rad,
+                Sweep& sweep)
+        {
+            HLT_PROFILE_COUNT(FanSweeps, 1);
+            const double distance = ship.location.get_distance_to(target);
+            const double angle_rad = ship.location.orient_towards_in_rad(target);
+
+            // Obstacles entirely behind the ship cannot block a heading within 90 degrees.
+            const bool skip_behind = (max_corrections - 1) * angular_step_rad < M_PI / 2;
+            const double heading_x = std::cos(angle_rad);
+            const double heading_y = std::sin(angle_rad);
+
+            HeadingFan fan(angle_rad, angular_step_rad, max_corrections, sweep.coverage);
+            const auto add_obstacle = [&](const Location& center, const double radius) {
+                const double reach = radius + constants::FORECAST_FUDGE_FACTOR;
+                const double ahead = (center.pos_x - ship.location.pos_x) * heading_x
+                                     + (center.pos_y - ship.location.pos_y) * heading_y;
+                if ((skip_behind && ahead < -reach) || center == ship.location) {
+                    return;
+                }
+                fan.block(ship.location, distance, center, reach);
+            };
+            if (index != nullptr && index->is_built_for(map)) {
+                index->for_each_near(ship.location, distance, [&](const SpatialIndex::Obstacle& obstacle) {
+                    add_obstacle(obstacle.location, obstacle.radius);
+                });
+            } else {
+                for (const Planet& planet : map.planets) {
+                    add_obstacle(planet.location, planet.radius);
+                }
+                for (const auto& player_ship : map.ships) {
+                    for (const Ship& other : player_ship.second) {
+                        add_obstacle(other.location, other.radius);
+                    }
+                }
+            }
+            fan.finish();
+
+            sweep.angles_deg.clear();
+            for (int correction = 0; correction < max_corrections; ++correction) {
+                for (int side = 0; side < (correction == 0 ? 1 : 2); ++side) {
+                    const int k = side == 0 ? correction : -correction;
+                    if (fan.is_blocked(k)) {
+                        HLT_PROFILE_COUNT(Corrections, 1);
+                        continue;
+                    }
+                    const int angle_deg = util::angle_rad_to_deg_clipped(fan.angle_rad(k));
+                    if (is_in_map(map, toLocation(ship.location, sweep.thrust, angle_deg))) {
+                        sweep.angles_deg.push_back(angle_deg);
+                    }
+                }
+            }
+            sweep.complete = true;
+        }
+
+        /**
+         * The read-only half of navigate_ship_towards_target_sweep: only reads
+         * map and index, so it may run on any thread. The budget is passed in
+         * because the turn clock belongs to the thread that started it.
+         *
+         * The direct heading usually works, and one segment query is cheaper
+         * than a fan, so the fan is left to commit_sweep() when it is clear.
+         */
+        static void prepare_sweep(
+                const Map& map,
+                const SpatialIndex* index,
+                const Ship& ship,
+                const Location& target,
+                const int max_thrust,
+                const int max_corrections,
+                const double angular_step_rad,
+                const TurnBudget budget,
+                Sweep& sweep)
+        {
+            HLT_PROFILE_SCOPE(Navigation);
+            sweep.angles_deg.clear();
+            sweep.complete = true;
+            if (max_corrections <= 0 || budget == TurnBudget::Exhausted) {
+                return;
+            }
+
+            const double distance = ship.location.get_distance_to(target);
+            // Do not round up, since overshooting might cause collision.
+            sweep.thrust = distance < max_thrust ? (int) distance : max_thrust;
+
+            const int direct_angle_deg = util::angle_rad_to_deg_clipped(ship.location.orient_towards_in_rad(target));
+            if (!any_object_between(map, index, ship.location, target)
+                && is_in_map(map, toLocation(ship.location, sweep.thrust, direct_angle_deg))) {
+                sweep.angles_deg.push_back(direct_angle_deg);
+                // Once time runs low only the direct heading is ever tried.
+                sweep.complete = budget == TurnBudget::Low;
+                return;
+            }
+            if (budget == TurnBudget::Low) {
+                return;
+            }
+
+            sweep_fan(map, index, ship, target, max_corrections, angular_step_rad, sweep);
+        }
+
+        /**
+         * The serial half: take the first heading of sweep that does not run
+         * into a path already reserved this turn, and reserve it. Builds the
+         * fan on demand if the direct heading was clear of obstacles but not
+         * of our ships.
+         */
+        static possibly<Move> commit_sweep(
+                const Map& map,
+                const Ship& ship,
+                const Location& target,
+                const int max_corrections,
+                const double angular_step_rad,
+                Sweep& sweep)
+        {
+            HLT_PROFILE_SCOPE(Navigation);
+            // Logged once per ship rather than per heading; formatting the message costs more than the check.
+            bool logged_my_ship = false;
+            for (;;) {
+                for (const int angle_deg : sweep.angles_deg) {
+                    const Location result = toLocation(ship.location, sweep.thrust, angle_deg);
+                    if (there_will_be_my_ship_at(ship.location, result)) {
+                        HLT_PROFILE_COUNT(Corrections, 1);
+                        if (!logged_my_ship) {
+                            HLT_LOG(Debug, "THERE WILL BE MY SHIP: " << ship.entity_id << " LOCATION: " << ship.location);
+                            logged_my_ship = true;
+                        }
+                        continue;
+                    }
+
+                    reservations.reserve(ship.location, result);
+                    return { Move::thrust(ship.entity_id, sweep.thrust, angle_deg), true };
+                }
+                if (sweep.complete) {
+                    return { Move::noop(), false };
+                }
+                sweep_fan(map, &obstacle_index, ship, target, max_corrections, angular_step_rad, sweep);
+            }
+        }
+
+        /**
+         * Same inputs and result as navigate_ship_towards_target, but sweeping
+         * all corrections at once instead of recursing; see sweep_fan(). The
+         * free heading closest to the direct one, turning either way, is taken.
+         *
+         * Degrades with the turn budget: once it runs low only the direct
+         * heading is tried, and once it is exhausted no move is found at all.
+         */
+        static possibly<Move> navigate_ship_towards_target_sweep(
+                const Map& map,
+                const Ship& ship,
+                const Location& target,
+                const int max_thrust,
+                const bool avoid_obstacles,
+                const int max_corrections,
+                const double angular_step_rad)
+        {
+            HLT_PROFILE_SCOPE(Navigation);
+            const TurnBudget budget = TurnTimer::budget();
+            if (!avoid_obstacles) {
+                if (max_corrections <= 0 || budget == TurnBudget::Exhausted) {
+                    return { Move::noop(), false };
+                }
+                const double distance = ship.location.get_distance_to(target);
+                const int thrust = distance < max_thrust ? (int) distance : max_thrust;
+                const int angle_deg = util::angle_rad_to_deg_clipped(ship.location.orient_towards_in_rad(target));
+                reservations.reserve(ship.location, toLocation(ship.location, thrust, angle_deg));
+                return { Move::thrust(ship.entity_id, thrust, angle_deg), true };
+            }
+
+            static thread_local Sweep sweep;
+            prepare_sweep(map, &obstacle_index, ship, target, max_thrust, max_corrections, angular_step_rad, budget, sweep);
+            return commit_sweep(map, ship, target, max_corrections, angular_step_rad, sweep);
+        }
+
         static possibly<Move> navigate_ship_to_dock(
                 const Map& map,
                 const Ship& ship,
@@ -120,7 +495,7 @@ namespace hlt {
             const double angular_step_rad = M_PI / 180.0;
             const Location& target = ship.location.get_closest_point(dock_target.location, dock_target.radius);
 
-            return navigate_ship_towards_target(
+            return navigate_ship_towards_target_sweep(
                     map, ship, target, max_thrust, avoid_obstacles, max_corrections, angular_step_rad);
         }
         
@@ -130,7 +505,7 @@ namespace hlt {
             const double angular_step_rad = M_PI / 180.0;
             const int max_thrust = constants::MAX_SPEED;
             
-            return navigate_ship_towards_target(map, ship, target, max_thrust, avoid_obstacles, max_corrections, angular_step_rad);
+            return navigate_ship_towards_target_sweep(map, ship, target, max_thrust, avoid_obstacles, max_corrections, angular_step_rad);
         }
     }
 }
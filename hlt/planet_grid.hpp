@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "collision.hpp"
+#include "constants.hpp"
+#include "grid_walk.hpp"
+#include "map.hpp"
+
+namespace hlt {
+    /**
+     * Occupancy bitmap of the planets, inflated by FORECAST_FUDGE_FACTOR, over
+     * the same cells as SpatialIndex, so a segment walk over the index's
+     * cells can check the planets along the way without looking at any
+     * planet struct.
+     *
+     * A cell is occupied when some inflated planet reaches into it, which is
+     * tighter than the planet's bounding box, and then lists those planets.
+     * Free cells cost one byte load; only in occupied cells does the exact
+     * segment_circle_intersect run, for the planets they list. Any point
+     * within reach of a planet lies in one of its cells, so the answers are
+     * those of testing every planet.
+     *
+     * Planets never move, so the grid lasts until one is destroyed: update()
+     * once per turn only rebuilds it when the living planets change. Planet
+     * indices refer to the map of the last update().
+     */
+    class PlanetGrid {
+    public:
+        struct Disc {
+            Location location;
+            double radius;
+            /// Index into the planets of the map.
+            unsigned int planet;
+        };
+
+        PlanetGrid() : cols(0), rows(0), width(0), height(0) {
+        }
+
+        /// Rebuild the grid if the living planets of map differ from those it holds; returns whether it did.
+        bool update(const Map& map) {
+            if (holds(map)) {
+                return false;
+            }
+            build(map);
+            return true;
+        }
+
+        /// Whether cell ids are those of a SpatialIndex of map.
+        bool matches(const Map& map) const {
+            return map.map_width == width && map.map_height == height;
+        }
+
+        bool is_occupied(const int cell) const {
+            return occupied[cell] != 0;
+        }
+
+        /**
+         * Visit the Disc of each planet listed in cell that is in the way from
+         * start to target. A planet spanning several cells of a walk is
+         * visited from each. The visitor returns false to stop; so does this.
+         */
+        template<typename DiscVisitor>
+        bool for_each_hit_in_cell(const int cell, const Location& start, const Location& target, DiscVisitor visit) const {
+            for (unsigned int i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+                const unsigned int d = cell_entries[i];
+                if (is_hit(discs[d], start, target) && !visit(discs[d])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool any_between(const Location& start, const Location& target) const {
+            bool found = false;
+            for_each_between(start, target, [&](const Disc&) {
+                found = true;
+                return false;
+            });
+            return found;
+        }
+
+        /// Visit the Disc of each planet in the way from start to target, as for_each_hit_in_cell() does.
+        template<typename DiscVisitor>
+        void for_each_between(const Location& start, const Location& target, DiscVisitor visit) const {
+            grid_walk::for_each_cell_on_segment(start, target, constants::SPATIAL_INDEX_CELL_SIZE, cols, rows, [&](const int cell) {
+                return !occupied[cell] || for_each_hit_in_cell(cell, start, target, visit);
+            });
+        }
+
+        /// Visit the Disc of each planet whose inflated bounding box overlaps the square of half-width reach around center.
+        template<typename DiscVisitor>
+        void for_each_near(const Location& center, const double reach, DiscVisitor visit) const {
+            for (const Disc& disc : discs) {
+                const double extent = disc.radius + constants::FORECAST_FUDGE_FACTOR + reach;
+                if (std::abs(disc.location.pos_x - center.pos_x) <= extent
+                    && std::abs(disc.location.pos_y - center.pos_y) <= extent) {
+                    visit(disc);
+                }
+            }
+        }
+
+        size_t num_planets() const {
+            return discs.size();
+        }
+
+        size_t num_occupied_cells() const {
+            return static_cast<size_t>(std::count(occupied.begin(), occupied.end(), 1));
+        }
+
+    private:
+        /// Extra slack on registration so rounding in the cell walk never misses a grazing planet.
+        static constexpr double CELL_EPSILON = 1e-3;
+
+        int cols, rows;
+        int width, height;
+        /// Living planets, in map order, with the entity ids they were built from.
+        std::vector<Disc> discs;
+        std::vector<EntityId> ids;
+        /// One byte per cell, 1 when cell_entries lists planets for it.
+        std::vector<unsigned char> occupied;
+        std::vector<unsigned int> cell_start;
+        std::vector<unsigned int> cell_entries;
+        /// Scratch for build(), kept to reuse its capacity.
+        std::vector<unsigned int> cursor;
+
+        static bool is_hit(const Disc& disc, const Location& start, const Location& target) {
+            if (disc.location == start || disc.location == target) {
+                return false;
+            }
+            return collision::segment_circle_intersect(
+                    start, target, disc.location, disc.radius, constants::FORECAST_FUDGE_FACTOR);
+        }
+
+        /// Whether the grid was built from the same map size and the same living planets, in the same places.
+        bool holds(const Map& map) const {
+            if (!matches(map)) {
+                return false;
+            }
+            size_t d = 0;
+            for (size_t p = 0; p < map.planets.size(); ++p) {
+                const Planet& planet = map.planets[p];
+                if (!planet.is_alive()) {
+                    continue;
+                }
+                if (d == discs.size() || ids[d] != planet.entity_id || discs[d].planet != p
+                    || !(discs[d].location == planet.location) || discs[d].radius != planet.radius) {
+                    return false;
+                }
+                ++d;
+            }
+            return d == discs.size();
+        }
+
+        void build(const Map& map) {
+            width = map.map_width;
+            height = map.map_height;
+            cols = static_cast<int>(map.map_width / constants::SPATIAL_INDEX_CELL_SIZE) + 1;
+            rows = static_cast<int>(map.map_height / constants::SPATIAL_INDEX_CELL_SIZE) + 1;
+
+            discs.clear();
+            ids.clear();
+            for (size_t p = 0; p < map.planets.size(); ++p) {
+                const Planet& planet = map.planets[p];
+                if (planet.is_alive()) {
+                    discs.push_back({ planet.location, planet.radius, static_cast<unsigned int>(p) });
+                    ids.push_back(planet.entity_id);
+                }
+            }
+
+            // Counting sort of planets into the cells they reach: count, prefix sum, fill.
+            cell_start.assign(static_cast<size_t>(cols * rows + 1), 0);
+            for (const Disc& disc : discs) {
+                for_each_reached_cell(disc, [&](const int cell) {
+                    ++cell_start[cell + 1];
+                });
+            }
+            for (size_t i = 1; i < cell_start.size(); ++i) {
+                cell_start[i] += cell_start[i - 1];
+            }
+
+            cell_entries.resize(cell_start.back());
+            cursor.assign(cell_start.begin(), cell_start.end() - 1);
+            for (unsigned int d = 0; d < discs.size(); ++d) {
+                for_each_reached_cell(discs[d], [&](const int cell) {
+                    cell_entries[cursor[cell]++] = d;
+                });
+            }
+
+            occupied.resize(static_cast<size_t>(cols * rows));
+            for (size_t cell = 0; cell < occupied.size(); ++cell) {
+                occupied[cell] = cell_start[cell] != cell_start[cell + 1];
+            }
+        }
+
+        /// Cells the inflated disc reaches into: those whose nearest point is within reach, not merely its bounding box.
+        template<typename CellVisitor>
+        void for_each_reached_cell(const Disc& disc, CellVisitor visit) const {
+            const double size = constants::SPATIAL_INDEX_CELL_SIZE;
+            const double inv_size = 1.0 / size;
+            const double reach = disc.radius + constants::FORECAST_FUDGE_FACTOR + CELL_EPSILON;
+            const double cx = disc.location.pos_x;
+            const double cy = disc.location.pos_y;
+            const int x0 = clamp_col(static_cast<int>(std::floor((cx - reach) * inv_size)));
+            const int y0 = clamp_row(static_cast<int>(std::floor((cy - reach) * inv_size)));
+            const int x1 = clamp_col(static_cast<int>(std::floor((cx + reach) * inv_size)));
+            const int y1 = clamp_row(static_cast<int>(std::floor((cy + reach) * inv_size)));
+
+            for (int y = y0; y <= y1; ++y) {
+                // Border cells also hold everything past the edge of the map.
+                const double low_y = y == 0 ? -HUGE_VAL : y * size;
+                const double high_y = y == rows - 1 ? HUGE_VAL : (y + 1) * size;
+                const double gap_y = std::max(0.0, std::max(low_y - cy, cy - high_y));
+                for (int x = x0; x <= x1; ++x) {
+                    const double low_x = x == 0 ? -HUGE_VAL : x * size;
+                    const double high_x = x == cols - 1 ? HUGE_VAL : (x + 1) * size;
+                    const double gap_x = std::max(0.0, std::max(low_x - cx, cx - high_x));
+                    if (gap_x * gap_x + gap_y * gap_y <= reach * reach) {
+                        visit(y * cols + x);
+                    }
+                }
+            }
+        }
+
+        int clamp_col(const int x) const {
+            return std::max(0, std::min(cols - 1, x));
+        }
+
+        int clamp_row(const int y) const {
+            return std::max(0, std::min(rows - 1, y));
+        }
+    };
+}
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "turn_timer.hpp"
+
+/**
+ * 1 builds in the hot-path counters and timers below; at 0, the default,
+ * HLT_PROFILE_SCOPE and HLT_PROFILE_COUNT compile to nothing.
+ */
+#ifndef HLT_PROFILE
+#define HLT_PROFILE 0
+#endif
+
+#if HLT_PROFILE
+#define HLT_PROFILE_CONCAT_(a, b) a##b
+#define HLT_PROFILE_CONCAT(a, b) HLT_PROFILE_CONCAT_(a, b)
+
+/// Time the rest of the enclosing scope under hlt::profile::Section::section.
+#define HLT_PROFILE_SCOPE(section) \
+    ::hlt::profile::ScopedTimer HLT_PROFILE_CONCAT(hlt_profile_scope_, __LINE__)(::hlt::profile::Section::section)
+
+/// Add n to hlt::profile::Counter::counter.
+#define HLT_PROFILE_COUNT(counter, n) ::hlt::profile::count(::hlt::profile::Counter::counter, n)
+#else
+#define HLT_PROFILE_SCOPE(section) do { } while (false)
+#define HLT_PROFILE_COUNT(counter, n) do { } while (false)
+#endif
+
+namespace hlt {
+    namespace profile {
+        enum class Counter {
+            /// Segment against circle tests, one per circle in the batched kernels.
+            SegmentCircleTests = 0,
+            /// objects_between and any_object_between calls.
+            ObstacleQueries,
+            /// Heading fans built by the sweep navigator.
+            FanSweeps,
+            /// Headings found blocked by an obstacle or by a path already reserved this turn.
+            Corrections,
+        };
+
+        enum class Section {
+            Parse = 0,
+            Strategy,
+            /// Summed over threads, so with a WorkerPool it can exceed the turn.
+            Navigation,
+            Output,
+        };
+
+        static const int NUM_COUNTERS = 4;
+        static const int NUM_SECTIONS = 4;
+
+        static const char* const COUNTER_NAMES[NUM_COUNTERS] = {
+                "segment_circle_tests", "obstacle_queries", "fan_sweeps", "corrections",
+        };
+
+        static const char* const SECTION_NAMES[NUM_SECTIONS] = {
+                "parse_ms", "strategy_ms", "navigation_ms", "output_ms",
+        };
+
+        /**
+         * Totals of one thread. Only the owning thread writes them, so adding
+         * is a plain load and store; they are atomic so end_turn() can read
+         * them from another thread.
+         */
+        struct ThreadTotals {
+            std::atomic<std::uint64_t> counts[NUM_COUNTERS];
+            std::atomic<std::uint64_t> section_ns[NUM_SECTIONS];
+            int depth[NUM_SECTIONS];
+
+            ThreadTotals() {
+                for (int i = 0; i < NUM_COUNTERS; ++i) {
+                    counts[i].store(0, std::memory_order_relaxed);
+                }
+                for (int i = 0; i < NUM_SECTIONS; ++i) {
+                    section_ns[i].store(0, std::memory_order_relaxed);
+                    depth[i] = 0;
+                }
+            }
+
+            static void add(std::atomic<std::uint64_t>& total, const std::uint64_t value) {
+                total.store(total.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            }
+        };
+
+        /**
+         * Process-wide profile: every thread counts into its own totals, and
+         * end_turn() closes a row of what all threads added since the last
+         * row. Rows are kept from open() on, and written out at exit as
+         * PREFIX.csv, one line per turn, and PREFIX.txt, the mean, p95 and
+         * max of every column.
+         *
+         * One game per process: games played side by side, as in
+         * halite_batch, would all count into the same rows.
+         */
+        class Profiler {
+        public:
+            static Profiler& get() {
+                static Profiler instance{};
+                return instance;
+            }
+
+            static constexpr bool compiled() {
+                return HLT_PROFILE != 0;
+            }
+
+            /// This thread's totals, registered with the profiler on first use.
+            static ThreadTotals& local() {
+                static thread_local ThreadTotals* totals = get().add_thread();
+                return *totals;
+            }
+
+            static void open(const std::string& prefix) {
+                if (!compiled()) {
+                    return;
+                }
+                Profiler& profiler = get();
+                std::lock_guard<std::mutex> lock(profiler.mutex);
+                profiler.prefix = prefix;
+                profiler.rows.clear();
+                profiler.sum(profiler.previous);
+            }
+
+            /// Close the current turn's row. The first row after open() is the pre-game.
+            static void end_turn() {
+                if (!compiled()) {
+                    return;
+                }
+                Profiler& profiler = get();
+                std::lock_guard<std::mutex> lock(profiler.mutex);
+                if (profiler.prefix.empty()) {
+                    return;
+                }
+                Sums now;
+                profiler.sum(now);
+                Row row;
+                row.turn_ms = TurnTimer::elapsed_ms();
+                for (int i = 0; i < NUM_SECTIONS; ++i) {
+                    row.section_ms[i] = (now.section_ns[i] - profiler.previous.section_ns[i]) / 1e6;
+                }
+                for (int i = 0; i < NUM_COUNTERS; ++i) {
+                    row.counts[i] = now.counts[i] - profiler.previous.counts[i];
+                }
+                profiler.rows.push_back(row);
+                profiler.previous = now;
+            }
+
+            /// Write the profile now rather than at exit, and stop keeping rows.
+            static void write() {
+                Profiler& profiler = get();
+                std::lock_guard<std::mutex> lock(profiler.mutex);
+                profiler.write_files();
+            }
+
+            Profiler() = default;
+            Profiler(const Profiler&) = delete;
+            Profiler& operator=(const Profiler&) = delete;
+
+            ~Profiler() {
+                write_files();
+            }
+
+        private:
+            struct Sums {
+                std::uint64_t counts[NUM_COUNTERS] = {};
+                std::uint64_t section_ns[NUM_SECTIONS] = {};
+            };
+
+            struct Row {
+                double turn_ms;
+                double section_ms[NUM_SECTIONS];
+                std::uint64_t counts[NUM_COUNTERS];
+            };
+
+            std::mutex mutex;
+            // Never freed: a thread may still count into its totals while the process exits.
+            std::vector<ThreadTotals*> threads;
+            std::string prefix;
+            Sums previous;
+            std::vector<Row> rows;
+
+            ThreadTotals* add_thread() {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.push_back(new ThreadTotals());
+                return threads.back();
+            }
+
+            void sum(Sums& sums) const {
+                sums = Sums();
+                for (const ThreadTotals* totals : threads) {
+                    for (int i = 0; i < NUM_COUNTERS; ++i) {
+                        sums.counts[i] += totals->counts[i].load(std::memory_order_relaxed);
+                    }
+                    for (int i = 0; i < NUM_SECTIONS; ++i) {
+                        sums.section_ns[i] += totals->section_ns[i].load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            /// Column c of every row: 0 is the turn time, then the sections, then the counters.
+            std::vector<double> column(const int c) const {
+                std::vector<double> values;
+                values.reserve(rows.size());
+                for (const Row& row : rows) {
+                    if (c == 0) {
+                        values.push_back(row.turn_ms);
+                    } else if (c <= NUM_SECTIONS) {
+                        values.push_back(row.section_ms[c - 1]);
+                    } else {
+                        values.push_back(static_cast<double>(row.counts[c - 1 - NUM_SECTIONS]));
+                    }
+                }
+                return values;
+            }
+
+            static const char* column_name(const int c) {
+                if (c == 0) {
+                    return "turn_ms";
+                }
+                return c <= NUM_SECTIONS ? SECTION_NAMES[c - 1] : COUNTER_NAMES[c - 1 - NUM_SECTIONS];
+            }
+
+            void write_files() {
+                if (prefix.empty() || rows.empty()) {
+                    return;
+                }
+                const int num_columns = 1 + NUM_SECTIONS + NUM_COUNTERS;
+
+                if (std::FILE* csv = std::fopen((prefix + ".csv").c_str(), "w")) {
+                    std::fprintf(csv, "turn");
+                    for (int c = 0; c < num_columns; ++c) {
+                        std::fprintf(csv, ",%s", column_name(c));
+                    }
+                    std::fprintf(csv, "\n");
+                    for (size_t turn = 0; turn < rows.size(); ++turn) {
+                        const Row& row = rows[turn];
+                        std::fprintf(csv, "%d,%.4f", static_cast<int>(turn), row.turn_ms);
+                        for (int i = 0; i < NUM_SECTIONS; ++i) {
+                            std::fprintf(csv, ",%.4f", row.section_ms[i]);
+                        }
+                        for (int i = 0; i < NUM_COUNTERS; ++i) {
+                            std::fprintf(csv, ",%llu", static_cast<unsigned long long>(row.counts[i]));
+                        }
+                        std::fprintf(csv, "\n");
+                    }
+                    std::fclose(csv);
+                }
+
+                if (std::FILE* summary = std::fopen((prefix + ".txt").c_str(), "w")) {
+                    std::fprintf(summary, "%d turns, pre-game included\n", static_cast<int>(rows.size()));
+                    std::fprintf(summary, "%-22s %12s %12s %12s\n", "", "mean", "p95", "max");
+                    for (int c = 0; c < num_columns; ++c) {
+                        std::vector<double> values = column(c);
+                        double total = 0;
+                        for (const double value : values) {
+                            total += value;
+                        }
+                        std::sort(values.begin(), values.end());
+                        const size_t p95 = std::min(values.size() - 1, values.size() * 95 / 100);
+                        std::fprintf(summary, "%-22s %12.3f %12.3f %12.3f\n", column_name(c),
+                                     total / values.size(), values[p95], values.back());
+                    }
+                    std::fclose(summary);
+                }
+                rows.clear();
+                prefix.clear();
+            }
+        };
+
+        static void count(const Counter counter, const std::uint64_t n) {
+            ThreadTotals::add(Profiler::local().counts[static_cast<int>(counter)], n);
+        }
+
+        /// Adds the time until it goes out of scope to its section; nested timers of the same section count once.
+        class ScopedTimer {
+        public:
+            explicit ScopedTimer(const Section section) :
+                    totals(Profiler::local()), index(static_cast<int>(section)) {
+                if (totals.depth[index]++ == 0) {
+                    started = std::chrono::steady_clock::now();
+                }
+            }
+
+            ScopedTimer(const ScopedTimer&) = delete;
+            ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+            ~ScopedTimer() {
+                if (--totals.depth[index] == 0) {
+                    const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - started;
+                    ThreadTotals::add(totals.section_ns[index], static_cast<std::uint64_t>(elapsed.count()));
+                }
+            }
+
+        private:
+            ThreadTotals& totals;
+            const int index;
+            std::chrono::steady_clock::time_point started;
+        };
+    }
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "types.hpp"
+
+namespace hlt {
+    namespace replay {
+        /**
+         * A recording is the line "HLTREPLAY 1", then one record per line the
+         * bot read or wrote, in order:
+         *
+         *     <tag> <payload length>\n<payload>\n
+         *
+         * with tag 'H' for the header ("player_id width height bot_name"),
+         * 'F' for a frame as read from the engine and 'M' for the command
+         * line sent back, both without their newline. The length prefix keeps
+         * reading exact whatever the payload holds.
+         */
+        static const char* const MAGIC = "HLTREPLAY 1";
+
+        struct Header {
+            PlayerId player_id = 0;
+            int map_width = 0;
+            int map_height = 0;
+            std::string bot_name;
+        };
+
+        struct Turn {
+            std::string frame;
+            /// The command line the bot answered with; empty if it never did, e.g. when killed.
+            std::string moves;
+            bool answered = false;
+        };
+
+        struct Recording {
+            Header header;
+            std::string pregame_frame;
+            std::vector<Turn> turns;
+        };
+
+        /**
+         * Appends a game to a recording file as it is played. Each turn is
+         * written out once its moves are, so a bot killed mid-game leaves a
+         * recording of every turn it finished.
+         */
+        class Recorder {
+        public:
+            /// The process's recorder, fed by hlt::in and hlt::out once started.
+            static Recorder& get() {
+                static Recorder instance{};
+                return instance;
+            }
+
+            Recorder() = default;
+            Recorder(const Recorder&) = delete;
+            Recorder& operator=(const Recorder&) = delete;
+
+            ~Recorder() {
+                close();
+            }
+
+            bool start(const std::string& filename, const Header& header) {
+                close();
+                file = std::fopen(filename.c_str(), "wb");
+                if (file == nullptr) {
+                    return false;
+                }
+                std::fprintf(file, "%s\n", MAGIC);
+                const std::string fields = std::to_string(header.player_id) + " " + std::to_string(header.map_width)
+                                           + " " + std::to_string(header.map_height) + " " + header.bot_name;
+                write('H', fields.data(), fields.size());
+                return true;
+            }
+
+            bool is_open() const {
+                return file != nullptr;
+            }
+
+            void frame(const std::string& line) {
+                if (file != nullptr) {
+                    write('F', line.data(), line.size());
+                }
+            }
+
+            /// Record a command line as sent, with or without its newline.
+            void moves(const char* data, size_t size) {
+                if (file == nullptr) {
+                    return;
+                }
+                if (size > 0 && data[size - 1] == '\n') {
+                    --size;
+                }
+                write('M', data, size);
+                std::fflush(file);
+            }
+
+            void close() {
+                if (file != nullptr) {
+                    std::fclose(file);
+                    file = nullptr;
+                }
+            }
+
+        private:
+            std::FILE* file = nullptr;
+
+            void write(const char tag, const char* data, const size_t size) {
+                std::fprintf(file, "%c %zu\n", tag, size);
+                std::fwrite(data, 1, size, file);
+                std::fputc('\n', file);
+            }
+        };
+
+        /// Parse a recording file, false with a message in error if it is not one.
+        static bool load(const std::string& filename, Recording& recording, std::string& error) {
+            std::FILE* file = std::fopen(filename.c_str(), "rb");
+            if (file == nullptr) {
+                error = "cannot open " + filename;
+                return false;
+            }
+            std::string contents;
+            char chunk[1 << 16];
+            size_t read;
+            while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+                contents.append(chunk, read);
+            }
+            std::fclose(file);
+
+            const std::string magic_line = std::string(MAGIC) + "\n";
+            if (contents.compare(0, magic_line.size(), magic_line) != 0) {
+                error = filename + " is not a recording";
+                return false;
+            }
+
+            recording = Recording();
+            bool have_header = false;
+            bool have_pregame = false;
+            size_t at = magic_line.size();
+            while (at < contents.size()) {
+                const size_t line_end = contents.find('\n', at);
+                if (line_end == std::string::npos || line_end < at + 3 || contents[at + 1] != ' ') {
+                    error = "malformed record at byte " + std::to_string(at);
+                    return false;
+                }
+                const char tag = contents[at];
+                const size_t size = std::strtoul(contents.c_str() + at + 2, nullptr, 10);
+                const size_t payload_at = line_end + 1;
+                if (payload_at + size + 1 > contents.size() || contents[payload_at + size] != '\n') {
+                    // A recording cut off mid-record, e.g. by a crash: keep the complete records.
+                    break;
+                }
+                const std::string payload = contents.substr(payload_at, size);
+                at = payload_at + size + 1;
+
+                if (tag == 'H') {
+                    int player_id;
+                    int name_at = 0;
+                    if (std::sscanf(payload.c_str(), "%d %d %d %n", &player_id, &recording.header.map_width,
+                                    &recording.header.map_height, &name_at) < 3 || name_at == 0) {
+                        error = "malformed header";
+                        return false;
+                    }
+                    recording.header.player_id = static_cast<PlayerId>(player_id);
+                    recording.header.bot_name = payload.substr(static_cast<size_t>(name_at));
+                    have_header = true;
+                } else if (tag == 'F') {
+                    if (!have_pregame) {
+                        recording.pregame_frame = payload;
+                        have_pregame = true;
+                    } else {
+                        recording.turns.emplace_back();
+                        recording.turns.back().frame = payload;
+                    }
+                } else if (tag == 'M') {
+                    if (recording.turns.empty() || recording.turns.back().answered) {
+                        error = "moves without a frame at byte " + std::to_string(payload_at);
+                        return false;
+                    }
+                    recording.turns.back().moves = payload;
+                    recording.turns.back().answered = true;
+                } else {
+                    error = std::string("unknown record '") + tag + "'";
+                    return false;
+                }
+            }
+            if (!have_header || !have_pregame) {
+                error = filename + " holds no game";
+                return false;
+            }
+            return true;
+        }
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "constants.hpp"
+#include "location.hpp"
+
+namespace hlt {
+    /**
+     * The paths our own ships have committed to this turn, hashed into a
+     * uniform grid so a new path is only checked against the few paths that
+     * pass nearby.
+     *
+     * A path is the segment a ship sweeps during the turn. Two ships moving
+     * at the same time conflict when they come within reach of each other at
+     * any moment of the turn, not just when their end points are close.
+     *
+     * Cells are buckets of path indices that keep their capacity, and only the
+     * cells used this turn are emptied by clear(), so steady-state turns
+     * allocate nothing.
+     */
+    class Reservations {
+    public:
+        /// Closest the centers of two of our ships may come: a ship radius plus the usual safety margin.
+        static constexpr double REACH = constants::SHIP_RADIUS + constants::FORECAST_FUDGE_FACTOR;
+
+        Reservations() : cols(0), rows(0) {
+        }
+
+        /// Drop every reservation and size the grid for a map.
+        void clear(const int map_width, const int map_height) {
+            for (const int cell : used_cells) {
+                buckets[cell].clear();
+            }
+            used_cells.clear();
+            paths.clear();
+
+            const int new_cols = static_cast<int>(map_width / constants::SPATIAL_INDEX_CELL_SIZE) + 1;
+            const int new_rows = static_cast<int>(map_height / constants::SPATIAL_INDEX_CELL_SIZE) + 1;
+            if (new_cols != cols || new_rows != rows) {
+                cols = new_cols;
+                rows = new_rows;
+                buckets.assign(static_cast<size_t>(cols * rows), std::vector<unsigned int>());
+            }
+        }
+
+        size_t size() const {
+            return paths.size();
+        }
+
+        /// Commit a ship to moving from start to end this turn.
+        void reserve(const Location& start, const Location& end) {
+            const unsigned int index = static_cast<unsigned int>(paths.size());
+            paths.push_back({ start, end });
+
+            int x0, y0, x1, y1;
+            cell_range(start, end, 0, x0, y0, x1, y1);
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    std::vector<unsigned int>& bucket = buckets[cell_id(x, y)];
+                    if (bucket.empty()) {
+                        used_cells.push_back(cell_id(x, y));
+                    }
+                    bucket.push_back(index);
+                }
+            }
+        }
+
+        /// Whether a ship moving from start to end would come within REACH of a reserved path.
+        bool conflicts(const Location& start, const Location& end) const {
+            if (paths.empty()) {
+                return false;
+            }
+
+            int x0, y0, x1, y1;
+            cell_range(start, end, REACH, x0, y0, x1, y1);
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    for (const unsigned int index : buckets[cell_id(x, y)]) {
+                        if (paths_meet(paths[index], start, end)) {
+                            return true;
+                        }
+                    }
+                }
+            }
+            return false;
+        }
+
+    private:
+        struct Path {
+            Location start;
+            Location end;
+        };
+
+        int cols;
+        int rows;
+        std::vector<Path> paths;
+        std::vector<std::vector<unsigned int>> buckets;
+        std::vector<int> used_cells;
+
+        int cell_id(const int x, const int y) const {
+            return y * cols + x;
+        }
+
+        /// Cells touched by the bounding box of a segment, grown by margin and clamped to the grid.
+        void cell_range(const Location& start, const Location& end, const double margin,
+                        int& x0, int& y0, int& x1, int& y1) const
+        {
+            const double inv_size = 1.0 / constants::SPATIAL_INDEX_CELL_SIZE;
+            x0 = clamp(static_cast<int>(std::floor((std::min(start.pos_x, end.pos_x) - margin) * inv_size)), cols);
+            y0 = clamp(static_cast<int>(std::floor((std::min(start.pos_y, end.pos_y) - margin) * inv_size)), rows);
+            x1 = clamp(static_cast<int>(std::floor((std::max(start.pos_x, end.pos_x) + margin) * inv_size)), cols);
+            y1 = clamp(static_cast<int>(std::floor((std::max(start.pos_y, end.pos_y) + margin) * inv_size)), rows);
+        }
+
+        static int clamp(const int value, const int count) {
+            return std::max(0, std::min(count - 1, value));
+        }
+
+        /**
+         * Both ships move at constant velocity over the turn, so their offset
+         * is linear in time; find its smallest length for t in [0, 1].
+         */
+        static bool paths_meet(const Path& path, const Location& start, const Location& end) {
+            const double offset_x = start.pos_x - path.start.pos_x;
+            const double offset_y = start.pos_y - path.start.pos_y;
+            const double velocity_x = (end.pos_x - start.pos_x) - (path.end.pos_x - path.start.pos_x);
+            const double velocity_y = (end.pos_y - start.pos_y) - (path.end.pos_y - path.start.pos_y);
+
+            const double speed_squared = velocity_x * velocity_x + velocity_y * velocity_y;
+            double t = 0;
+            if (speed_squared > 0) {
+                t = -(offset_x * velocity_x + offset_y * velocity_y) / speed_squared;
+                t = std::max(0.0, std::min(1.0, t));
+            }
+            const double closest_x = offset_x + velocity_x * t;
+            const double closest_y = offset_y + velocity_y * t;
+            return closest_x * closest_x + closest_y * closest_y < REACH * REACH;
+        }
+    };
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "collision.hpp"
+#include "constants.hpp"
+#include "grid_walk.hpp"
+#include "map.hpp"
+#include "planet_grid.hpp"
+
+namespace hlt {
+    /**
+     * Uniform grid over every planet and ship of a Map, used to answer
+     * "what lies along this segment" without scanning the whole map.
+     *
+     * Each entity is registered in every cell touched by its bounding box
+     * inflated by FORECAST_FUDGE_FACTOR, so a segment query only has to look
+     * at the cells the segment itself passes through.
+     *
+     * The index copies entity geometry when it is built; rebuild it whenever
+     * the map changes (normally once per turn). The Entity pointers it hands
+     * out point into the Map it was built from.
+     *
+     * Built with a PlanetGrid updated from the same map, the index only holds
+     * the ships, and the same cell walk checks the grid's planets, which do
+     * not have to be registered again every turn.
+     */
+    class SpatialIndex {
+    public:
+        struct Obstacle {
+            Location location;
+            double radius;
+            const Entity* entity;
+        };
+
+        SpatialIndex() : cols(0), rows(0), source(nullptr), source_generation(0), planet_grid(nullptr) {
+        }
+
+        /// Index map; planet_grid, if given, must have been updated from map and outlive this build.
+        void build(const Map& map, const PlanetGrid* planet_grid = nullptr) {
+            source = &map;
+            source_generation = map.generation;
+            this->planet_grid = planet_grid != nullptr && planet_grid->matches(map) ? planet_grid : nullptr;
+            cols = static_cast<int>(map.map_width / constants::SPATIAL_INDEX_CELL_SIZE) + 1;
+            rows = static_cast<int>(map.map_height / constants::SPATIAL_INDEX_CELL_SIZE) + 1;
+
+            obstacles.clear();
+            if (this->planet_grid == nullptr) {
+                for (const Planet& planet : map.planets) {
+                    obstacles.push_back({ planet.location, planet.radius, &planet });
+                }
+            }
+            for (const auto& player_ships : map.ships) {
+                for (const Ship& ship : player_ships.second) {
+                    obstacles.push_back({ ship.location, ship.radius, &ship });
+                }
+            }
+
+            // Counting sort of obstacles into cells: count, prefix sum, fill.
+            cell_start.assign(static_cast<size_t>(cols * rows + 1), 0);
+            origins.clear();
+            for (const Obstacle& obstacle : obstacles) {
+                int x0, y0, x1, y1;
+                cell_range(obstacle, x0, y0, x1, y1);
+                origins.push_back({ x0, y0 });
+                for (int y = y0; y <= y1; ++y) {
+                    for (int x = x0; x <= x1; ++x) {
+                        ++cell_start[cell_id(x, y) + 1];
+                    }
+                }
+            }
+            for (size_t i = 1; i < cell_start.size(); ++i) {
+                cell_start[i] += cell_start[i - 1];
+            }
+
+            cell_entries.resize(cell_start.back());
+            cursor.assign(cell_start.begin(), cell_start.end() - 1);
+            for (unsigned int i = 0; i < obstacles.size(); ++i) {
+                int x0, y0, x1, y1;
+                cell_range(obstacles[i], x0, y0, x1, y1);
+                for (int y = y0; y <= y1; ++y) {
+                    for (int x = x0; x <= x1; ++x) {
+                        cell_entries[cursor[cell_id(x, y)]++] = i;
+                    }
+                }
+            }
+        }
+
+        /// Whether the index was built from map as it is now, not from an earlier turn of the same Map.
+        bool is_built_for(const Map& map) const {
+            return source == &map && source_generation == map.generation;
+        }
+
+        void clear() {
+            source = nullptr;
+            planet_grid = nullptr;
+            obstacles.clear();
+            origins.clear();
+            cell_start.clear();
+            cell_entries.clear();
+        }
+
+        /// Same contract as navigation::objects_between; results are not in map order.
+        std::vector<const Entity *> objects_between(const Location& start, const Location& target) const {
+            std::vector<const Entity *> entities_found;
+
+            for_each_cell_on_segment(start, target, [&](const int cell) {
+                if (planet_grid != nullptr && planet_grid->is_occupied(cell)) {
+                    planet_grid->for_each_hit_in_cell(cell, start, target, [&](const PlanetGrid::Disc& disc) {
+                        const Entity* planet = &source->planets[disc.planet];
+                        if (std::find(entities_found.begin(), entities_found.end(), planet) == entities_found.end()) {
+                            entities_found.push_back(planet);
+                        }
+                        return true;
+                    });
+                }
+                for (unsigned int i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+                    const Obstacle& obstacle = obstacles[cell_entries[i]];
+                    if (is_hit(obstacle, start, target)
+                        && std::find(entities_found.begin(), entities_found.end(), obstacle.entity) == entities_found.end()) {
+                        entities_found.push_back(obstacle.entity);
+                    }
+                }
+                return true;
+            });
+
+            return entities_found;
+        }
+
+        /// Equivalent to !objects_between(start, target).empty(), but stops at the first hit.
+        bool any_between(const Location& start, const Location& target) const {
+            bool found = false;
+
+            for_each_cell_on_segment(start, target, [&](const int cell) {
+                if (planet_grid != nullptr && planet_grid->is_occupied(cell)
+                    && !planet_grid->for_each_hit_in_cell(cell, start, target, [](const PlanetGrid::Disc&) {
+                        return false;
+                    })) {
+                    found = true;
+                    return false;
+                }
+                for (unsigned int i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+                    if (is_hit(obstacles[cell_entries[i]], start, target)) {
+                        found = true;
+                        return false;
+                    }
+                }
+                return true;
+            });
+
+            return found;
+        }
+
+        /**
+         * Visit each obstacle whose inflated bounding box overlaps the square of
+         * half-width reach around center, exactly once. This is a superset of
+         * the obstacles that any segment of length reach from center can hit.
+         */
+        template<typename ObstacleVisitor>
+        void for_each_near(const Location& center, const double reach, ObstacleVisitor visit) const {
+            if (cols == 0) {
+                return;
+            }
+            if (planet_grid != nullptr) {
+                planet_grid->for_each_near(center, reach, [&](const PlanetGrid::Disc& disc) {
+                    visit(Obstacle{ disc.location, disc.radius, &source->planets[disc.planet] });
+                });
+            }
+
+            const double inv_size = 1.0 / constants::SPATIAL_INDEX_CELL_SIZE;
+            const int qx0 = clamp_col(static_cast<int>(std::floor((center.pos_x - reach) * inv_size)));
+            const int qy0 = clamp_row(static_cast<int>(std::floor((center.pos_y - reach) * inv_size)));
+            const int qx1 = clamp_col(static_cast<int>(std::floor((center.pos_x + reach) * inv_size)));
+            const int qy1 = clamp_row(static_cast<int>(std::floor((center.pos_y + reach) * inv_size)));
+
+            for (int y = qy0; y <= qy1; ++y) {
+                for (int x = qx0; x <= qx1; ++x) {
+                    const int cell = cell_id(x, y);
+                    for (unsigned int i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+                        // An obstacle spans a rectangle of cells; report it only from the
+                        // first cell of that rectangle which lies inside the query.
+                        const CellOrigin& origin = origins[cell_entries[i]];
+                        if (x == std::max(origin.x, qx0) && y == std::max(origin.y, qy0)) {
+                            visit(obstacles[cell_entries[i]]);
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        /// Extra slack on registration so rounding in the cell walk never misses a grazing entity.
+        static constexpr double CELL_EPSILON = 1e-3;
+
+        int cols, rows;
+        const Map* source;
+        unsigned long source_generation;
+        /// Where the planets are, when they are not among the obstacles; it has the same cells.
+        const PlanetGrid* planet_grid;
+
+        /// First cell of each obstacle's rectangle, parallel to obstacles.
+        struct CellOrigin {
+            int x, y;
+        };
+
+        std::vector<Obstacle> obstacles;
+        std::vector<CellOrigin> origins;
+        std::vector<unsigned int> cell_start;
+        std::vector<unsigned int> cell_entries;
+        /// Scratch for build(), kept to reuse its capacity.
+        std::vector<unsigned int> cursor;
+
+        static bool is_hit(const Obstacle& obstacle, const Location& start, const Location& target) {
+            if (obstacle.location == start || obstacle.location == target) {
+                return false;
+            }
+            return collision::segment_circle_intersect(
+                    start, target, obstacle.location, obstacle.radius, constants::FORECAST_FUDGE_FACTOR);
+        }
+
+        int cell_id(const int x, const int y) const {
+            return y * cols + x;
+        }
+
+        int clamp_col(const int x) const {
+            return std::max(0, std::min(cols - 1, x));
+        }
+
+        int clamp_row(const int y) const {
+            return std::max(0, std::min(rows - 1, y));
+        }
+
+        void cell_range(const Obstacle& obstacle, int& x0, int& y0, int& x1, int& y1) const {
+            const double reach = obstacle.radius + constants::FORECAST_FUDGE_FACTOR + CELL_EPSILON;
+            const double inv_size = 1.0 / constants::SPATIAL_INDEX_CELL_SIZE;
+            x0 = clamp_col(static_cast<int>(std::floor((obstacle.location.pos_x - reach) * inv_size)));
+            y0 = clamp_row(static_cast<int>(std::floor((obstacle.location.pos_y - reach) * inv_size)));
+            x1 = clamp_col(static_cast<int>(std::floor((obstacle.location.pos_x + reach) * inv_size)));
+            y1 = clamp_row(static_cast<int>(std::floor((obstacle.location.pos_y + reach) * inv_size)));
+        }
+
+        template<typename CellVisitor>
+        void for_each_cell_on_segment(const Location& start, const Location& end, CellVisitor visit) const {
+            grid_walk::for_each_cell_on_segment(start, end, constants::SPATIAL_INDEX_CELL_SIZE, cols, rows, visit);
+        }
+    };
+}
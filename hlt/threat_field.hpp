@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "constants.hpp"
+#include "entity_store.hpp"
+
+namespace hlt {
+    /// What one of our ships is up against this turn; see ThreatField.
+    struct Threat {
+        /// Undocked enemy ships closer than the field's range.
+        int enemies = 0;
+        /// Docked enemy ships closer than the field's range.
+        int docked_enemies = 0;
+        /// Our other undocked ships closer than the field's range.
+        int allies = 0;
+        /**
+         * Damage the ship can take next turn if it stays: every armed enemy
+         * that can get within WEAPON_RADIUS splits WEAPON_DAMAGE over all our
+         * ships it could reach.
+         */
+        double incoming_damage = 0;
+        /// Mean of the bearings from each enemy to the ship, in radians; only set when enemies > 0.
+        double flee_rads = 0;
+        /// Unit vector away from the enemies, each weighted equally; zero when there are none.
+        double escape_x = 0;
+        double escape_y = 0;
+    };
+
+    /**
+     * Per-turn threat assessment of every ship of one player, in a single
+     * pass over a grid of all ships.
+     *
+     * Ships are bucketed into cells at least as large as the farthest
+     * distance the field looks, so each ship only visits the 3x3 cells
+     * around it, and each cell's ships lie contiguously in plain arrays of
+     * coordinates and flags. Storage is reused from turn to turn.
+     */
+    class ThreatField {
+    public:
+        /// Enemies this close (center to center) can move into WEAPON_RADIUS and fire next turn.
+        static constexpr double DAMAGE_REACH = constants::WEAPON_RADIUS + 2 * constants::SHIP_RADIUS + constants::MAX_SPEED;
+
+        /**
+         * Assess player_id's ships in entities. Enemies, docked enemies and
+         * allies are counted below range; incoming damage always looks as
+         * far as DAMAGE_REACH.
+         */
+        void compute(const EntityStore& entities, const PlayerId player_id, const double range) {
+            build_grid(entities, range > DAMAGE_REACH ? range : DAMAGE_REACH);
+            owner = player_id;
+            target_counts.assign(xs.size(), -1);
+
+            const EntityStore::Range mine = entities.ships(player_id);
+            threats.assign(mine.size(), Threat());
+            for (unsigned int slot = mine.begin; slot < mine.end; ++slot) {
+                assess(entities, slot, range, threats[slot - mine.begin]);
+            }
+        }
+
+        /// The threat to the player's i-th ship, in map order.
+        const Threat& operator[](const size_t i) const {
+            return threats[i];
+        }
+
+        size_t size() const {
+            return threats.size();
+        }
+
+    private:
+        double cell_size = 1;
+        int cols = 0;
+        int rows = 0;
+        PlayerId owner = -1;
+
+        // Every ship, sorted by cell; the ships of cell c are [cell_start[c], cell_start[c + 1]).
+        std::vector<unsigned int> cell_start;
+        std::vector<double> xs;
+        std::vector<double> ys;
+        std::vector<PlayerId> owners;
+        std::vector<unsigned char> undocked;
+        /// Undocked with a weapon that is ready by next turn's combat.
+        std::vector<unsigned char> armed;
+        std::vector<unsigned int> slots;
+
+        std::vector<Threat> threats;
+        /// How many of our ships each entry could reach, or -1 until needed.
+        std::vector<int> target_counts;
+        /// Scratch: slots of the enemies close to the ship being assessed.
+        std::vector<unsigned int> nearby;
+        /// Scratch for build_grid().
+        std::vector<int> cell_of_ship;
+
+        int cell_col(const double x) const {
+            return std::max(0, std::min(cols - 1, static_cast<int>(x / cell_size)));
+        }
+
+        int cell_row(const double y) const {
+            return std::max(0, std::min(rows - 1, static_cast<int>(y / cell_size)));
+        }
+
+        void build_grid(const EntityStore& entities, const double size) {
+            cell_size = size;
+            cols = static_cast<int>(entities.map_width / cell_size) + 1;
+            rows = static_cast<int>(entities.map_height / cell_size) + 1;
+
+            const EntityStore::Range ships = entities.ships();
+            cell_start.assign(static_cast<size_t>(cols * rows + 1), 0);
+            cell_of_ship.resize(ships.size());
+            for (unsigned int slot = ships.begin; slot < ships.end; ++slot) {
+                const int cell = cell_row(entities.pos_y[slot]) * cols + cell_col(entities.pos_x[slot]);
+                cell_of_ship[slot - ships.begin] = cell;
+                ++cell_start[cell];
+            }
+            for (size_t cell = 1; cell < cell_start.size(); ++cell) {
+                cell_start[cell] += cell_start[cell - 1];
+            }
+
+            xs.resize(ships.size());
+            ys.resize(ships.size());
+            owners.resize(ships.size());
+            undocked.resize(ships.size());
+            armed.resize(ships.size());
+            slots.resize(ships.size());
+            // Each cell's count ends at its end; filling back to front moves it to its start.
+            for (unsigned int slot = ships.end; slot-- > ships.begin;) {
+                const unsigned int k = --cell_start[cell_of_ship[slot - ships.begin]];
+                xs[k] = entities.pos_x[slot];
+                ys[k] = entities.pos_y[slot];
+                owners[k] = entities.owner_id[slot];
+                undocked[k] = entities.docking_status[slot] == ShipDockingStatus::Undocked;
+                // The engine counts cooldowns down before combat.
+                armed[k] = undocked[k] && entities.weapon_cooldown[slot] - 1 <= 0;
+                slots[k] = slot;
+            }
+        }
+
+        /// Call visit(k) for every grid entry in the 3x3 cells around (x, y).
+        template<typename Visit>
+        void for_each_near(const double x, const double y, Visit visit) const {
+            const int cx = cell_col(x);
+            const int cy = cell_row(y);
+            for (int row = std::max(0, cy - 1); row <= std::min(rows - 1, cy + 1); ++row) {
+                for (int col = std::max(0, cx - 1); col <= std::min(cols - 1, cx + 1); ++col) {
+                    const int cell = row * cols + col;
+                    for (unsigned int k = cell_start[cell]; k < cell_start[cell + 1]; ++k) {
+                        visit(k);
+                    }
+                }
+            }
+        }
+
+        /// Our ships, docked or not, that the enemy at entry k could reach to fire on; at least the one asking.
+        int targets_of(const unsigned int k) {
+            if (target_counts[k] < 0) {
+                int count = 0;
+                for_each_near(xs[k], ys[k], [&](const unsigned int j) {
+                    const double dx = xs[j] - xs[k];
+                    const double dy = ys[j] - ys[k];
+                    count += owners[j] == owner && std::sqrt(dx * dx + dy * dy) <= DAMAGE_REACH;
+                });
+                target_counts[k] = count;
+            }
+            return target_counts[k];
+        }
+
+        void assess(const EntityStore& entities, const unsigned int slot, const double range, Threat& threat) {
+            const Location location = { entities.pos_x[slot], entities.pos_y[slot] };
+            nearby.clear();
+
+            for_each_near(location.pos_x, location.pos_y, [&](const unsigned int k) {
+                if (slots[k] == slot) {
+                    return;
+                }
+                const double dx = xs[k] - location.pos_x;
+                const double dy = ys[k] - location.pos_y;
+                const double distance = std::sqrt(dx * dx + dy * dy);
+                if (owners[k] == owner) {
+                    threat.allies += undocked[k] && distance < range;
+                    return;
+                }
+                if (distance < range) {
+                    if (undocked[k]) {
+                        nearby.push_back(slots[k]);
+                    } else {
+                        ++threat.docked_enemies;
+                    }
+                }
+                if (armed[k] && distance <= DAMAGE_REACH) {
+                    threat.incoming_damage += static_cast<double>(constants::WEAPON_DAMAGE) / targets_of(k);
+                }
+            });
+
+            threat.enemies = static_cast<int>(nearby.size());
+            if (nearby.empty()) {
+                return;
+            }
+            // In slot order, so the mean bearing is summed the same way whatever the grid looks like.
+            std::sort(nearby.begin(), nearby.end());
+            double total_rads = 0;
+            for (const unsigned int enemy : nearby) {
+                const Location enemy_location = { entities.pos_x[enemy], entities.pos_y[enemy] };
+                total_rads += enemy_location.orient_towards_in_rad(location);
+
+                const double distance = enemy_location.get_distance_to(location);
+                if (distance > 0) {
+                    threat.escape_x += (location.pos_x - enemy_location.pos_x) / distance;
+                    threat.escape_y += (location.pos_y - enemy_location.pos_y) / distance;
+                }
+            }
+            threat.flee_rads = total_rads / threat.enemies;
+
+            const double length = std::sqrt(threat.escape_x * threat.escape_x + threat.escape_y * threat.escape_y);
+            if (length > 0) {
+                threat.escape_x /= length;
+                threat.escape_y /= length;
+            }
+        }
+    };
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace hlt {
+    namespace in {
+        /**
+         * Reads whitespace-separated numbers straight out of a NUL-terminated
+         * character buffer, without copying tokens or touching the locale.
+         *
+         * Produces the same values operator>> would for the engine's output:
+         * plain decimal numbers take an exact fast path, anything else is
+         * handed to strtod.
+         */
+        class Tokenizer {
+        public:
+            explicit Tokenizer(const char* text) : cursor(text) {
+            }
+
+            long next_long() {
+                skip_space();
+                const bool negative = *cursor == '-';
+                if (*cursor == '-' || *cursor == '+') {
+                    ++cursor;
+                }
+                long value = 0;
+                while (is_digit(*cursor)) {
+                    value = value * 10 + (*cursor - '0');
+                    ++cursor;
+                }
+                return negative ? -value : value;
+            }
+
+            int next_int() {
+                return static_cast<int>(next_long());
+            }
+
+            unsigned int next_uint() {
+                return static_cast<unsigned int>(next_long());
+            }
+
+            double next_double() {
+                skip_space();
+                const char* token = cursor;
+
+                const bool negative = *cursor == '-';
+                if (*cursor == '-' || *cursor == '+') {
+                    ++cursor;
+                }
+
+                uint64_t mantissa = 0;
+                int digits = 0;
+                int exponent = 0;
+                while (is_digit(*cursor)) {
+                    mantissa = mantissa * 10 + (*cursor - '0');
+                    digits += mantissa != 0;
+                    ++cursor;
+                }
+                if (*cursor == '.') {
+                    ++cursor;
+                    while (is_digit(*cursor)) {
+                        mantissa = mantissa * 10 + (*cursor - '0');
+                        digits += mantissa != 0;
+                        --exponent;
+                        ++cursor;
+                    }
+                }
+
+                // Both the mantissa and the power of ten are exact doubles here,
+                // so a single multiply or divide is correctly rounded, exactly
+                // like strtod. Exponents, long mantissas etc. go the slow way.
+                const bool exact = digits <= 15 && exponent >= -22 && *cursor != 'e' && *cursor != 'E'
+                                   && cursor != token && (is_space(*cursor) || *cursor == '\0');
+                if (!exact) {
+                    char* end;
+                    const double value = std::strtod(token, &end);
+                    cursor = end;
+                    return value;
+                }
+
+                const double value = exponent == 0
+                                     ? static_cast<double>(mantissa)
+                                     : static_cast<double>(mantissa) / power_of_ten(-exponent);
+                return negative ? -value : value;
+            }
+
+            bool at_end() {
+                skip_space();
+                return *cursor == '\0';
+            }
+
+        private:
+            const char* cursor;
+
+            static bool is_digit(const char c) {
+                return c >= '0' && c <= '9';
+            }
+
+            static bool is_space(const char c) {
+                return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+            }
+
+            static double power_of_ten(const int exponent) {
+                static const double powers[] = {
+                        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+                };
+                return powers[exponent];
+            }
+
+            void skip_space() {
+                while (is_space(*cursor)) {
+                    ++cursor;
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+
+#include "constants.hpp"
+
+namespace hlt {
+    /// How much of the current turn's time is left to spend.
+    enum class TurnBudget {
+        /// Plenty of time: use full navigation.
+        Full,
+        /// Running low: fall back to cheap navigation.
+        Low,
+        /// Out of time: stop issuing moves and send what we have.
+        Exhausted,
+    };
+
+    /**
+     * Monotonic wall-clock deadline for the current turn. Started by
+     * hlt::in::get_map as soon as a frame has been read, so frame parsing
+     * counts against the budget just like it does on the engine's clock.
+     * Each thread has its own timer.
+     */
+    struct TurnTimer {
+    private:
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        double limit = constants::TURN_TIME_LIMIT_MS;
+
+    public:
+        static TurnTimer& get() {
+            static thread_local TurnTimer instance{};
+            return instance;
+        }
+
+        /// Restart the clock with the engine's time limit for this turn.
+        static void start(const double limit_ms) {
+            get().started = std::chrono::steady_clock::now();
+            get().limit = limit_ms;
+        }
+
+        static double elapsed_ms() {
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - get().started;
+            return elapsed.count();
+        }
+
+        static double limit_ms() {
+            return get().limit;
+        }
+
+        /// Time left before we must start sending moves, i.e. excluding the reserve.
+        static double remaining_ms() {
+            return get().limit - constants::TURN_TIME_RESERVE_MS - elapsed_ms();
+        }
+
+        static TurnBudget budget() {
+            const double remaining = remaining_ms();
+            if (remaining <= 0) {
+                return TurnBudget::Exhausted;
+            }
+            if (remaining < constants::TURN_TIME_LOW_MS) {
+                return TurnBudget::Low;
+            }
+            return TurnBudget::Full;
+        }
+    };
+}
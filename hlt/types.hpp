@@ -1,6 +1,6 @@
 #pragma once
 
-#include <unordered_map>
+#include "arena.hpp"
 
 namespace hlt {
     /// Uniquely identifies each player.
@@ -15,8 +15,9 @@ namespace hlt {
      */
     typedef unsigned int EntityId;
 
+    /// Id lookup table; on the heap unless built with an ArenaAllocator that has an arena.
     template<typename T>
-    using entity_map = std::unordered_map<EntityId, T>;
+    using entity_map = arena_unordered_map<EntityId, T>;
 
     /// A poor man's std::optional.
     template<typename T>
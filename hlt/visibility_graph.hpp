@@ -0,0 +1,443 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "constants.hpp"
+#include "map.hpp"
+
+namespace hlt {
+    /**
+     * Shortest paths around the planets, which never move, so that a ship
+     * whose way is blocked by a planet heads for the right side of it
+     * instead of sweeping headings one degree at a time.
+     *
+     * Each planet, inflated by FORECAST_FUDGE_FACTOR, is circumscribed by a
+     * polygon of NODES_PER_PLANET corners. The corners are the nodes of the
+     * graph. Two nodes are joined when the segment between them misses every
+     * inflated planet and a shortest path could use it: it runs along a
+     * polygon's side, or only grazes the polygons at both ends. Built from
+     * the pre-game map, and again by update() when a planet is destroyed;
+     * the shortest paths from every node to every planet, and so between
+     * every pair of planets, are cached then as well.
+     *
+     * Queries only read the graph, so any number of threads may run them,
+     * though not while update() runs.
+     * Ships are not part of the graph: they move, and navigation steers
+     * around them each turn.
+     */
+    class VisibilityGraph {
+    public:
+        static const int NODES_PER_PLANET = 12;
+        /// How far outside an inflated planet its polygon's edges pass.
+        static constexpr double NODE_MARGIN = 0.5;
+
+        VisibilityGraph() {
+        }
+
+        explicit VisibilityGraph(const Map& map) {
+            build(map);
+        }
+
+        void build(const Map& map) {
+            planet_x.clear();
+            planet_y.clear();
+            planet_reach.clear();
+            planet_index.clear();
+            for (const Planet& planet : map.planets) {
+                if (!planet.is_alive()) {
+                    continue;
+                }
+                if (planet_index.size() <= planet.entity_id) {
+                    planet_index.resize(planet.entity_id + 1, -1);
+                }
+                planet_index[planet.entity_id] = static_cast<int>(planet_x.size());
+                planet_x.push_back(planet.location.pos_x);
+                planet_y.push_back(planet.location.pos_y);
+                planet_reach.push_back(planet.radius + constants::FORECAST_FUDGE_FACTOR);
+            }
+            build_nodes(map);
+            build_edges();
+            build_planet_distances();
+        }
+
+        /// Build the graph again if planets of map were destroyed since it was last built; returns whether it was.
+        bool update(const Map& map) {
+            // Planets are never added, so fewer living ones means some were destroyed.
+            const size_t alive = static_cast<size_t>(std::count_if(map.planets.begin(), map.planets.end(), [](const Planet& planet) {
+                return planet.is_alive();
+            }));
+            if (alive == planet_x.size()) {
+                return false;
+            }
+            build(map);
+            return true;
+        }
+
+        size_t num_nodes() const {
+            return nodes.size();
+        }
+
+        /// Joined pairs of nodes; each is stored once per direction.
+        size_t num_edges() const {
+            return edge_to.size() / 2;
+        }
+
+        /**
+         * Length of the shortest path from start to each of the count
+         * planets, into lengths: to the planet's inflated circle when it is
+         * in sight, otherwise to the nearest corner of its polygon along the
+         * graph. Infinity for a planet not in the graph or out of reach.
+         *
+         * Only looks for the corners in sight of start if some planet is not.
+         */
+        void path_lengths(const Location& start, const Planet* const* planets, const size_t count, double* lengths) const {
+            const int skip_start = planet_containing(start);
+            bool blocked = false;
+            for (size_t k = 0; k < count; ++k) {
+                const Planet& planet = *planets[k];
+                const int p = planet.entity_id < planet_index.size() ? planet_index[planet.entity_id] : -1;
+                lengths[k] = INFINITY;
+                if (p < 0) {
+                    continue;
+                }
+                const double distance = start.get_distance_to(planet.location);
+                const Location closest = start.get_closest_point(planet.location, planet_reach[p]);
+                if (distance <= planet_reach[p] || is_clear(start, closest, skip_start, p)) {
+                    lengths[k] = std::max(0.0, distance - planet_reach[p]);
+                } else {
+                    blocked = true;
+                }
+            }
+            if (!blocked) {
+                return;
+            }
+
+            static thread_local std::vector<unsigned int> in_sight;
+            in_sight.clear();
+            for (unsigned int n = 0; n < nodes.size(); ++n) {
+                if (is_tangent(n, start) && is_clear(start, nodes[n], skip_start, -1)) {
+                    in_sight.push_back(n);
+                }
+            }
+            const size_t num_planets = planet_x.size();
+            for (size_t k = 0; k < count; ++k) {
+                const Planet& planet = *planets[k];
+                const int p = planet.entity_id < planet_index.size() ? planet_index[planet.entity_id] : -1;
+                if (p < 0 || lengths[k] < INFINITY) {
+                    continue;
+                }
+                for (const unsigned int n : in_sight) {
+                    const double length = start.get_distance_to(nodes[n]) + node_distances[n * num_planets + p];
+                    lengths[k] = std::min(lengths[k], length);
+                }
+            }
+        }
+
+        /**
+         * Where a ship at start should head first to reach target along the
+         * shortest path around the planets: target itself if no planet is in
+         * the way, otherwise a corner of the polygon around a planet. Also
+         * target when there is no way around, or either end is in a spot no
+         * node can be reached from. A planet that start or target is inside
+         * of is not in their way.
+         *
+         * A* over the graph, with start and target joined to the corners
+         * that the line of sight from them grazes. The joins are checked for
+         * obstacles on demand: from start for the nodes A* picks, and to
+         * target for the nodes it closes.
+         */
+        Location first_waypoint(const Location& start, const Location& target) const {
+            const int skip_start = planet_containing(start);
+            const int skip_target = planet_containing(target);
+            if (is_clear(start, target, skip_start, skip_target) || nodes.empty()) {
+                return target;
+            }
+
+            static thread_local Search search;
+            Search& s = search;
+            const size_t count = nodes.size();
+            s.cost.resize(count);
+            s.first.resize(count);
+            s.state.assign(count, Unchecked);
+            s.open.clear();
+            for (unsigned int n = 0; n < count; ++n) {
+                s.first[n] = n;
+                if (is_tangent(n, start)) {
+                    s.cost[n] = start.get_distance_to(nodes[n]);
+                    s.open.push_back({ s.cost[n] + nodes[n].get_distance_to(target), n });
+                } else {
+                    s.cost[n] = INFINITY;
+                    s.state[n] = Reached;
+                }
+            }
+            std::make_heap(s.open.begin(), s.open.end(), std::greater<Entry>());
+
+            const unsigned int GOAL = static_cast<unsigned int>(count);
+            double goal_cost = INFINITY;
+            unsigned int goal_first = GOAL;
+            const auto push = [&](const double f, const unsigned int n) {
+                s.open.push_back({ f, n });
+                std::push_heap(s.open.begin(), s.open.end(), std::greater<Entry>());
+            };
+
+            while (!s.open.empty()) {
+                std::pop_heap(s.open.begin(), s.open.end(), std::greater<Entry>());
+                const Entry entry = s.open.back();
+                s.open.pop_back();
+                const unsigned int n = entry.node;
+                if (n == GOAL) {
+                    return nodes[goal_first];
+                }
+                if (s.state[n] == Closed || entry.f > s.cost[n] + nodes[n].get_distance_to(target)) {
+                    continue;
+                }
+
+                if (s.state[n] == Unchecked) {
+                    if (!is_clear(start, nodes[n], skip_start, -1)) {
+                        // Not in sight after all: the best way in is through a node already closed.
+                        s.state[n] = Reached;
+                        s.cost[n] = INFINITY;
+                        for (unsigned int e = edge_start[n]; e < edge_start[n + 1]; ++e) {
+                            const unsigned int from = edge_to[e];
+                            if (s.state[from] == Closed && s.cost[from] + edge_length[e] < s.cost[n]) {
+                                s.cost[n] = s.cost[from] + edge_length[e];
+                                s.first[n] = s.first[from];
+                            }
+                        }
+                        if (s.cost[n] < INFINITY) {
+                            push(s.cost[n] + nodes[n].get_distance_to(target), n);
+                        }
+                        continue;
+                    }
+                }
+                s.state[n] = Closed;
+
+                const double to_goal = s.cost[n] + nodes[n].get_distance_to(target);
+                if (to_goal < goal_cost && is_tangent(n, target) && is_clear(nodes[n], target, -1, skip_target)) {
+                    goal_cost = to_goal;
+                    goal_first = s.first[n];
+                    push(goal_cost, GOAL);
+                }
+                for (unsigned int e = edge_start[n]; e < edge_start[n + 1]; ++e) {
+                    const unsigned int to = edge_to[e];
+                    const double cost = s.cost[n] + edge_length[e];
+                    if (s.state[to] != Closed && cost < s.cost[to]) {
+                        s.cost[to] = cost;
+                        s.first[to] = s.first[n];
+                        s.state[to] = Reached;
+                        push(cost + nodes[to].get_distance_to(target), to);
+                    }
+                }
+            }
+            return target;
+        }
+
+    private:
+        /// How far A* has got with a node: Unchecked ones are only assumed to be in sight of start.
+        enum NodeState : unsigned char {
+            Unchecked,
+            Reached,
+            Closed,
+        };
+
+        struct Entry {
+            double f;
+            unsigned int node;
+
+            bool operator>(const Entry& other) const {
+                return f > other.f || (f == other.f && node > other.node);
+            }
+        };
+
+        /// Per-thread scratch of first_waypoint().
+        struct Search {
+            std::vector<double> cost;
+            std::vector<unsigned int> first;
+            std::vector<NodeState> state;
+            std::vector<Entry> open;
+        };
+
+        // Living planets of the map the graph was built from, inflated.
+        std::vector<double> planet_x;
+        std::vector<double> planet_y;
+        std::vector<double> planet_reach;
+        /// Index into the planets above by planet id, or -1.
+        std::vector<int> planet_index;
+
+        std::vector<Location> nodes;
+        std::vector<unsigned int> node_planet;
+        /// The corners on either side of each node on its polygon, whether or not they are nodes themselves.
+        std::vector<Location> node_prev;
+        std::vector<Location> node_next;
+        /// The nodes joined to node n are edge_to[edge_start[n]] to edge_to[edge_start[n + 1] - 1].
+        std::vector<unsigned int> edge_start;
+        std::vector<unsigned int> edge_to;
+        std::vector<double> edge_length;
+        /// node_distances[n * planet_x.size() + p]: length of the shortest path from node n to a node of planet p.
+        std::vector<float> node_distances;
+
+        /// The planet whose inflated circle holds location, or -1.
+        int planet_containing(const Location& location) const {
+            for (size_t p = 0; p < planet_x.size(); ++p) {
+                const double dx = location.pos_x - planet_x[p];
+                const double dy = location.pos_y - planet_y[p];
+                if (dx * dx + dy * dy < planet_reach[p] * planet_reach[p]) {
+                    return static_cast<int>(p);
+                }
+            }
+            return -1;
+        }
+
+        /**
+         * Whether the line from location through node n only grazes n's
+         * polygon: a shortest path that bends at n comes in or leaves along
+         * such a line, never through the polygon.
+         */
+        bool is_tangent(const unsigned int n, const Location& location) const {
+            const double dx = nodes[n].pos_x - location.pos_x;
+            const double dy = nodes[n].pos_y - location.pos_y;
+            const double prev_side = dx * (node_prev[n].pos_y - location.pos_y) - dy * (node_prev[n].pos_x - location.pos_x);
+            const double next_side = dx * (node_next[n].pos_y - location.pos_y) - dy * (node_next[n].pos_x - location.pos_x);
+            return prev_side * next_side >= 0;
+        }
+
+        /// Whether the segment from a to b misses every inflated planet other than skip_a and skip_b.
+        bool is_clear(const Location& a, const Location& b, const int skip_a, const int skip_b) const {
+            const double dx = b.pos_x - a.pos_x;
+            const double dy = b.pos_y - a.pos_y;
+            const double length2 = dx * dx + dy * dy;
+            const double min_x = std::min(a.pos_x, b.pos_x);
+            const double max_x = std::max(a.pos_x, b.pos_x);
+            const double min_y = std::min(a.pos_y, b.pos_y);
+            const double max_y = std::max(a.pos_y, b.pos_y);
+            for (size_t p = 0; p < planet_x.size(); ++p) {
+                const double reach = planet_reach[p];
+                if (planet_x[p] + reach < min_x || planet_x[p] - reach > max_x
+                    || planet_y[p] + reach < min_y || planet_y[p] - reach > max_y) {
+                    continue;
+                }
+                if (static_cast<int>(p) == skip_a || static_cast<int>(p) == skip_b) {
+                    continue;
+                }
+                const double px = planet_x[p] - a.pos_x;
+                const double py = planet_y[p] - a.pos_y;
+                const double t = length2 > 0 ? std::max(0.0, std::min(1.0, (px * dx + py * dy) / length2)) : 0;
+                const double ex = px - t * dx;
+                const double ey = py - t * dy;
+                if (ex * ex + ey * ey <= reach * reach) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// Polygon corners that are on the map and outside every other inflated planet.
+        void build_nodes(const Map& map) {
+            nodes.clear();
+            node_planet.clear();
+            node_prev.clear();
+            node_next.clear();
+            const double corner_scale = 1 / std::cos(M_PI / NODES_PER_PLANET);
+            Location corners[NODES_PER_PLANET];
+            for (size_t p = 0; p < planet_x.size(); ++p) {
+                const double corner_distance = (planet_reach[p] + NODE_MARGIN) * corner_scale;
+                for (int k = 0; k < NODES_PER_PLANET; ++k) {
+                    const double angle_rad = 2 * M_PI * k / NODES_PER_PLANET;
+                    corners[k] = { planet_x[p] + corner_distance * std::cos(angle_rad),
+                                   planet_y[p] + corner_distance * std::sin(angle_rad) };
+                }
+                for (int k = 0; k < NODES_PER_PLANET; ++k) {
+                    const Location& corner = corners[k];
+                    if (corner.pos_x < 0 || corner.pos_x > map.map_width
+                        || corner.pos_y < 0 || corner.pos_y > map.map_height
+                        || planet_containing(corner) >= 0) {
+                        continue;
+                    }
+                    nodes.push_back(corner);
+                    node_planet.push_back(static_cast<unsigned int>(p));
+                    node_prev.push_back(corners[(k + NODES_PER_PLANET - 1) % NODES_PER_PLANET]);
+                    node_next.push_back(corners[(k + 1) % NODES_PER_PLANET]);
+                }
+            }
+        }
+
+        void build_edges() {
+            const unsigned int count = static_cast<unsigned int>(nodes.size());
+            std::vector<std::pair<unsigned int, unsigned int>> pairs;
+            for (unsigned int a = 0; a < count; ++a) {
+                for (unsigned int b = a + 1; b < count; ++b) {
+                    const bool side = node_planet[a] == node_planet[b]
+                                      && (nodes[b] == node_prev[a] || nodes[b] == node_next[a]);
+                    if ((side || (is_tangent(a, nodes[b]) && is_tangent(b, nodes[a])))
+                        && is_clear(nodes[a], nodes[b], -1, -1)) {
+                        pairs.push_back({ a, b });
+                    }
+                }
+            }
+
+            // Counting sort of both directions of every pair by their first node.
+            edge_start.assign(count + 1, 0);
+            for (const auto& pair : pairs) {
+                ++edge_start[pair.first];
+                ++edge_start[pair.second];
+            }
+            for (unsigned int n = 1; n <= count; ++n) {
+                edge_start[n] += edge_start[n - 1];
+            }
+            edge_to.resize(2 * pairs.size());
+            edge_length.resize(2 * pairs.size());
+            for (size_t i = pairs.size(); i-- > 0;) {
+                const unsigned int a = pairs[i].first;
+                const unsigned int b = pairs[i].second;
+                const double length = nodes[a].get_distance_to(nodes[b]);
+                const unsigned int ab = --edge_start[a];
+                edge_to[ab] = b;
+                edge_length[ab] = length;
+                const unsigned int ba = --edge_start[b];
+                edge_to[ba] = a;
+                edge_length[ba] = length;
+            }
+        }
+
+        /// Dijkstra from all the nodes of each planet at once.
+        void build_planet_distances() {
+            const size_t num_planets = planet_x.size();
+            node_distances.assign(nodes.size() * num_planets, INFINITY);
+            std::vector<double> cost;
+            std::vector<Entry> open;
+            for (size_t p = 0; p < num_planets; ++p) {
+                cost.assign(nodes.size(), INFINITY);
+                open.clear();
+                for (unsigned int n = 0; n < nodes.size(); ++n) {
+                    if (node_planet[n] == p) {
+                        cost[n] = 0;
+                        open.push_back({ 0, n });
+                    }
+                }
+                while (!open.empty()) {
+                    std::pop_heap(open.begin(), open.end(), std::greater<Entry>());
+                    const Entry entry = open.back();
+                    open.pop_back();
+                    const unsigned int n = entry.node;
+                    if (entry.f > cost[n]) {
+                        continue;
+                    }
+                    node_distances[n * num_planets + p] = static_cast<float>(cost[n]);
+                    for (unsigned int e = edge_start[n]; e < edge_start[n + 1]; ++e) {
+                        const unsigned int to = edge_to[e];
+                        if (cost[n] + edge_length[e] < cost[to]) {
+                            cost[to] = cost[n] + edge_length[e];
+                            open.push_back({ cost[to], to });
+                            std::push_heap(open.begin(), open.end(), std::greater<Entry>());
+                        }
+                    }
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hlt {
+    /**
+     * A fixed set of threads that run an indexed loop together with the
+     * calling thread, for the read-only part of a turn that splits per ship.
+     *
+     * Indices are handed out one at a time from a shared counter, so a thread
+     * that draws cheap ships simply takes more of them. The task must only
+     * write to state owned by its index; results are then read back in index
+     * order, so they do not depend on how the work was spread.
+     *
+     * Worker threads have their own thread_local state: a task must not rely
+     * on the caller's navigation state, Log or TurnTimer.
+     */
+    class WorkerPool {
+    public:
+        /// A pool of one runs everything on the calling thread and starts no threads.
+        explicit WorkerPool(const int threads) {
+            for (int i = 1; i < threads; ++i) {
+                workers.emplace_back([this]() { work(); });
+            }
+        }
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        ~WorkerPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+        }
+
+        /// Threads taking part in run(), the caller included.
+        int size() const {
+            return static_cast<int>(workers.size()) + 1;
+        }
+
+        /**
+         * Call task(i) for every i in [0, count) and return once all calls
+         * are done. Any callable will do; it is not copied into a
+         * std::function, which would allocate for most lambdas.
+         */
+        template<typename Task>
+        void run(const size_t count, const Task& task) {
+            if (workers.empty() || count < 2) {
+                for (size_t i = 0; i < count; ++i) {
+                    task(i);
+                }
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                current_task = &task;
+                invoke_task = &invoke<Task>;
+                task_count = count;
+                next_index = 0;
+                busy_workers = static_cast<int>(workers.size());
+                ++generation;
+            }
+            wake.notify_all();
+
+            run_share();
+
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this]() { return busy_workers == 0; });
+            current_task = nullptr;
+        }
+
+        /// Threads a bot should use when nothing else is said: one per core.
+        static int default_threads() {
+            const int configured = default_threads_setting();
+            if (configured > 0) {
+                return configured;
+            }
+            return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        }
+
+        /**
+         * Override default_threads() for the whole process, e.g. to 1 when
+         * many games already run side by side.
+         */
+        static void set_default_threads(const int threads) {
+            default_threads_setting() = threads;
+        }
+
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+
+        const void* current_task = nullptr;
+        void (*invoke_task)(const void*, size_t) = nullptr;
+        size_t task_count = 0;
+        std::atomic<size_t> next_index{ 0 };
+        int busy_workers = 0;
+        unsigned long generation = 0;
+        bool stopping = false;
+
+        static std::atomic<int>& default_threads_setting() {
+            static std::atomic<int> threads{ 0 };
+            return threads;
+        }
+
+        template<typename Task>
+        static void invoke(const void* task, const size_t i) {
+            (*static_cast<const Task*>(task))(i);
+        }
+
+        void run_share() {
+            for (size_t i = next_index++; i < task_count; i = next_index++) {
+                invoke_task(current_task, i);
+            }
+        }
+
+        void work() {
+            unsigned long seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&]() { return stopping || generation != seen; });
+                    if (stopping) {
+                        return;
+                    }
+                    seen = generation;
+                }
+
+                run_share();
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--busy_workers == 0) {
+                    done.notify_one();
+                }
+            }
+        }
+    };
+}
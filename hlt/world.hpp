@@ -0,0 +1,208 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "arena.hpp"
+#include "constants.hpp"
+#include "hlt_in.hpp"
+#include "map.hpp"
+#include "profile.hpp"
+#include "tokenizer.hpp"
+
+namespace hlt {
+    /**
+     * Game state that persists across turns and is updated in place from
+     * each frame, instead of building a new Map every turn.
+     *
+     * Ship and planet vectors, docked-ship lists and the id maps keep their
+     * storage; ids are only inserted into or erased from the maps when an
+     * entity appears or disappears, so steady-state turns allocate nothing.
+     * Per-entity records live in dense tables keyed by EntityId and stay put
+     * for the life of the game.
+     *
+     * The id maps allocate from an arena owned by the World, so even a spawn
+     * seldom reaches malloc. Memory of erased ids comes back only with the
+     * World, which for a game's worth of ships is a few tens of kilobytes.
+     *
+     * Each update also records what changed since the previous frame.
+     */
+    class World {
+    public:
+        /// A ship, identified the way Map identifies them.
+        struct ShipKey {
+            PlayerId owner_id;
+            EntityId ship_id;
+        };
+
+        /// Changes between the previous frame and the current one.
+        struct Delta {
+            /// New ships; on the first update, every ship.
+            std::vector<ShipKey> spawned;
+            std::vector<ShipKey> destroyed;
+            /// Ships that finished docking.
+            std::vector<ShipKey> docked;
+            /// Ships that finished undocking.
+            std::vector<ShipKey> undocked;
+            std::vector<EntityId> planets_destroyed;
+
+            void clear() {
+                spawned.clear();
+                destroyed.clear();
+                docked.clear();
+                undocked.clear();
+                planets_destroyed.clear();
+            }
+        };
+
+        World(const int map_width, const int map_height) : state(map_width, map_height), updates(0) {
+            state.planet_map = new_id_map();
+        }
+
+        // The maps point at this World's arena.
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+
+        const Map& map() const {
+            return state;
+        }
+
+        const Delta& delta() const {
+            return changes;
+        }
+
+        /// Bring the state up to date with one turn frame.
+        void update(const char* frame) {
+            HLT_PROFILE_SCOPE(Parse);
+            in::Tokenizer tokens(frame);
+            ++updates;
+            changes.clear();
+            state.generation = Map::next_generation();
+
+            bool player_in_frame[constants::MAX_PLAYERS] = {};
+            const int num_players = tokens.next_int();
+            for (int i = 0; i < num_players; ++i) {
+                const PlayerId player_id = static_cast<PlayerId>(tokens.next_int());
+                player_in_frame[player_id] = true;
+                update_ships(tokens, player_id, tokens.next_uint());
+            }
+            for (PlayerId player_id = 0; player_id < constants::MAX_PLAYERS; ++player_id) {
+                if (!player_in_frame[player_id] && state.ships.count(player_id)) {
+                    update_ships(tokens, player_id, 0);
+                }
+            }
+
+            update_planets(tokens, tokens.next_uint());
+        }
+
+        void update(const std::string& frame) {
+            update(frame.c_str());
+        }
+
+    private:
+        struct ShipRecord {
+            /// Number of the update that last saw this ship; 0 if never seen.
+            int last_seen;
+            ShipDockingStatus docking_status;
+        };
+
+        Arena id_arena;
+        Map state;
+        Delta changes;
+        int updates;
+
+        std::vector<ShipRecord> ship_records[constants::MAX_PLAYERS];
+        std::vector<int> planet_last_seen;
+
+        /// Scratch list of the previous frame's ids, kept to reuse its capacity.
+        std::vector<EntityId> previous_ids;
+
+        entity_map<unsigned int> new_id_map() {
+            return entity_map<unsigned int>(0, std::hash<EntityId>(), std::equal_to<EntityId>(), &id_arena);
+        }
+
+        void update_ships(in::Tokenizer& tokens, const PlayerId player_id, const unsigned int num_ships) {
+            std::vector<Ship>& ships = state.ships[player_id];
+            auto ship_map_it = state.ship_map.find(player_id);
+            if (ship_map_it == state.ship_map.end()) {
+                ship_map_it = state.ship_map.emplace(player_id, new_id_map()).first;
+            }
+            entity_map<unsigned int>& ship_map = ship_map_it->second;
+            std::vector<ShipRecord>& records = ship_records[player_id];
+
+            previous_ids.clear();
+            for (const Ship& ship : ships) {
+                previous_ids.push_back(ship.entity_id);
+            }
+
+            ships.resize(num_ships);
+            for (unsigned int i = 0; i < num_ships; ++i) {
+                Ship& ship = ships[i];
+                in::parse_ship(tokens, player_id, ship);
+
+                if (ship.entity_id >= records.size()) {
+                    records.resize(ship.entity_id + 1, ShipRecord{ 0, ShipDockingStatus::Undocked });
+                }
+                ShipRecord& record = records[ship.entity_id];
+                const ShipKey key = { player_id, ship.entity_id };
+                if (record.last_seen == 0 || record.last_seen != updates - 1) {
+                    changes.spawned.push_back(key);
+                } else if (ship.docking_status != record.docking_status) {
+                    if (ship.docking_status == ShipDockingStatus::Docked) {
+                        changes.docked.push_back(key);
+                    } else if (ship.docking_status == ShipDockingStatus::Undocked) {
+                        changes.undocked.push_back(key);
+                    }
+                }
+                record.last_seen = updates;
+                record.docking_status = ship.docking_status;
+
+                const auto it = ship_map.find(ship.entity_id);
+                if (it == ship_map.end()) {
+                    ship_map.emplace(ship.entity_id, i);
+                } else {
+                    it->second = i;
+                }
+            }
+
+            for (const EntityId ship_id : previous_ids) {
+                if (records[ship_id].last_seen != updates) {
+                    changes.destroyed.push_back({ player_id, ship_id });
+                    ship_map.erase(ship_id);
+                }
+            }
+        }
+
+        void update_planets(in::Tokenizer& tokens, const unsigned int num_planets) {
+            previous_ids.clear();
+            for (const Planet& planet : state.planets) {
+                previous_ids.push_back(planet.entity_id);
+            }
+
+            state.planets.resize(num_planets);
+            for (unsigned int i = 0; i < num_planets; ++i) {
+                Planet& planet = state.planets[i];
+                in::parse_planet(tokens, planet);
+
+                if (planet.entity_id >= planet_last_seen.size()) {
+                    planet_last_seen.resize(planet.entity_id + 1, 0);
+                }
+                planet_last_seen[planet.entity_id] = updates;
+
+                const auto it = state.planet_map.find(planet.entity_id);
+                if (it == state.planet_map.end()) {
+                    state.planet_map.emplace(planet.entity_id, i);
+                } else {
+                    it->second = i;
+                }
+            }
+
+            for (const EntityId planet_id : previous_ids) {
+                if (planet_last_seen[planet_id] != updates) {
+                    changes.planets_destroyed.push_back(planet_id);
+                    state.planet_map.erase(planet_id);
+                }
+            }
+        }
+    };
+}
@@ -4,4 +4,10 @@ set -e
 
 cmake .
 make MyBot
-./halite -d "240 160" "./MyBot" "./MyBot"
+if [ "$(uname)" = "Linux" ]; then
+    # ./halite is a macOS binary; use the bundled simulator instead.
+    make halite_sim
+    ./halite_sim -d "240 160" "./MyBot" "./MyBot"
+else
+    ./halite -d "240 160" "./MyBot" "./MyBot"
+fi
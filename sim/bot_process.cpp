@@ -0,0 +1,141 @@
+#include "bot_process.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace sim {
+    BotProcess::BotProcess(const std::string& command) : pid(-1), to_bot(-1), from_bot(-1) {
+        // exec, so the shell is replaced by the bot and signals reach the bot itself.
+        const std::string shell_command = "exec " + command;
+
+        int stdin_pipe[2];
+        int stdout_pipe[2];
+        if (pipe(stdin_pipe) != 0 || pipe(stdout_pipe) != 0) {
+            throw std::runtime_error("could not create pipes for: " + command);
+        }
+
+        pid = fork();
+        if (pid < 0) {
+            throw std::runtime_error("could not fork for: " + command);
+        }
+        if (pid == 0) {
+            dup2(stdin_pipe[0], STDIN_FILENO);
+            dup2(stdout_pipe[1], STDOUT_FILENO);
+            close(stdin_pipe[0]);
+            close(stdin_pipe[1]);
+            close(stdout_pipe[0]);
+            close(stdout_pipe[1]);
+            execl("/bin/sh", "sh", "-c", shell_command.c_str(), (char*) nullptr);
+            _exit(127);
+        }
+
+        close(stdin_pipe[0]);
+        close(stdout_pipe[1]);
+        to_bot = stdin_pipe[1];
+        from_bot = stdout_pipe[0];
+        fcntl(to_bot, F_SETFD, FD_CLOEXEC);
+        fcntl(from_bot, F_SETFD, FD_CLOEXEC);
+    }
+
+    BotProcess::~BotProcess() {
+        stop();
+    }
+
+    bool BotProcess::send_line(const std::string& line) {
+        if (to_bot < 0) {
+            return false;
+        }
+        const std::string data = line + "\n";
+        size_t written = 0;
+        while (written < data.size()) {
+            const ssize_t count = write(to_bot, data.data() + written, data.size() - written);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+            written += (size_t) count;
+        }
+        return true;
+    }
+
+    bool BotProcess::read_line(std::string& line, const int timeout_ms) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        char buffer[4096];
+
+        for (;;) {
+            const size_t newline = pending.find('\n');
+            if (newline != std::string::npos) {
+                line.assign(pending, 0, newline);
+                pending.erase(0, newline + 1);
+                return true;
+            }
+            if (from_bot < 0) {
+                return false;
+            }
+
+            int wait_ms = -1;
+            if (timeout_ms >= 0) {
+                const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - std::chrono::steady_clock::now());
+                if (left.count() <= 0) {
+                    return false;
+                }
+                wait_ms = (int) left.count();
+            }
+
+            pollfd readable = { from_bot, POLLIN, 0 };
+            const int ready = poll(&readable, 1, wait_ms);
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready <= 0) {
+                return false;
+            }
+
+            const ssize_t count = read(from_bot, buffer, sizeof(buffer));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+            pending.append(buffer, (size_t) count);
+        }
+    }
+
+    void BotProcess::stop() {
+        if (to_bot >= 0) {
+            close(to_bot);
+            to_bot = -1;
+        }
+        if (from_bot >= 0) {
+            close(from_bot);
+            from_bot = -1;
+        }
+        if (pid <= 0) {
+            return;
+        }
+
+        // Bots exit on their own once stdin closes; give them a moment before killing.
+        for (int i = 0; i < 100; ++i) {
+            if (waitpid(pid, nullptr, WNOHANG) == pid) {
+                pid = -1;
+                return;
+            }
+            usleep(10 * 1000);
+        }
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        pid = -1;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+#include <sys/types.h>
+
+namespace sim {
+    /**
+     * A bot running as a child process, talked to over its stdin and stdout
+     * one line at a time, like the engine does. The command is run through
+     * /bin/sh; the bot's stderr is left attached to ours. POSIX only.
+     */
+    class BotProcess {
+    public:
+        explicit BotProcess(const std::string& command);
+        ~BotProcess();
+
+        BotProcess(const BotProcess&) = delete;
+        BotProcess& operator=(const BotProcess&) = delete;
+
+        bool send_line(const std::string& line);
+
+        /**
+         * Read one line without its newline. Gives up after timeout_ms
+         * (negative waits forever) and returns false on timeout, EOF or error.
+         */
+        bool read_line(std::string& line, int timeout_ms);
+
+        /// Close the pipes and reap the process, killing it if it does not exit.
+        void stop();
+
+    private:
+        pid_t pid;
+        int to_bot;
+        int from_bot;
+        std::string pending;
+    };
+}
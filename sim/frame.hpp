@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "hlt/map.hpp"
+#include "hlt/move.hpp"
+
+namespace sim {
+    /**
+     * Encode a Map the way the engine sends a turn frame, players in id order.
+     * The inverse of hlt::in::parse_map.
+     */
+    static std::string write_frame(const hlt::Map& map) {
+        std::string frame;
+        char buffer[128];
+
+        std::snprintf(buffer, sizeof(buffer), "%d", (int) map.ships.size());
+        frame += buffer;
+        for (hlt::PlayerId player_id = 0; player_id < hlt::constants::MAX_PLAYERS; ++player_id) {
+            const auto it = map.ships.find(player_id);
+            if (it == map.ships.end()) {
+                continue;
+            }
+            std::snprintf(buffer, sizeof(buffer), " %d %d", player_id, (int) it->second.size());
+            frame += buffer;
+            for (const hlt::Ship& ship : it->second) {
+                std::snprintf(buffer, sizeof(buffer), " %u %.4f %.4f %d 0.0000 0.0000 %d %u %d %d",
+                              ship.entity_id, ship.location.pos_x, ship.location.pos_y, ship.health,
+                              (int) ship.docking_status, ship.docked_planet, ship.docking_progress,
+                              ship.weapon_cooldown);
+                frame += buffer;
+            }
+        }
+
+        std::snprintf(buffer, sizeof(buffer), " %d", (int) map.planets.size());
+        frame += buffer;
+        for (const hlt::Planet& planet : map.planets) {
+            std::snprintf(buffer, sizeof(buffer), " %u %.4f %.4f %d %.4f %u %d %d %d %d %d",
+                          planet.entity_id, planet.location.pos_x, planet.location.pos_y, planet.health,
+                          planet.radius, planet.docking_spots, planet.current_production,
+                          planet.remaining_production, planet.owned ? 1 : 0, planet.owned ? planet.owner_id : 0,
+                          (int) planet.docked_ships.size());
+            frame += buffer;
+            for (const hlt::EntityId ship_id : planet.docked_ships) {
+                std::snprintf(buffer, sizeof(buffer), " %u", ship_id);
+                frame += buffer;
+            }
+        }
+
+        return frame;
+    }
+
+    /**
+     * Decode one line of commands as sent by hlt::out::send_moves. Returns
+     * false if the line is malformed; moves then holds the commands read so far.
+     */
+    static bool parse_moves(const std::string& line, std::vector<hlt::Move>& moves) {
+        moves.clear();
+        const char* cursor = line.c_str();
+
+        const auto next_long = [&cursor](long& value) {
+            char* end;
+            value = std::strtol(cursor, &end, 10);
+            if (end == cursor) {
+                return false;
+            }
+            cursor = end;
+            return true;
+        };
+
+        for (;;) {
+            while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r') {
+                ++cursor;
+            }
+            if (*cursor == '\0') {
+                return true;
+            }
+
+            const char command = *cursor++;
+            long ship_id, first, second;
+            if (!next_long(ship_id) || ship_id < 0) {
+                return false;
+            }
+            switch (command) {
+                case 't':
+                    if (!next_long(first) || !next_long(second)) {
+                        return false;
+                    }
+                    moves.push_back(hlt::Move::thrust((hlt::EntityId) ship_id, (int) first, (int) second));
+                    break;
+                case 'd':
+                    if (!next_long(first) || first < 0) {
+                        return false;
+                    }
+                    moves.push_back(hlt::Move::dock((hlt::EntityId) ship_id, (hlt::EntityId) first));
+                    break;
+                case 'u':
+                    moves.push_back(hlt::Move::undock((hlt::EntityId) ship_id));
+                    break;
+                default:
+                    return false;
+            }
+        }
+    }
+}
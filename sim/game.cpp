@@ -0,0 +1,89 @@
+#include "game.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "frame.hpp"
+
+namespace sim {
+    Game::Game(hlt::Map initial_map, const int num_players, const int max_turns) :
+            state(std::move(initial_map)),
+            model_state(state, num_players),
+            players((size_t) num_players, PlayerState{ 0, false }),
+            max_turns(max_turns)
+    {
+        model_state.to_map(state);
+    }
+
+    int Game::default_max_turns(const int width, const int height) {
+        return 100 + (int) std::sqrt((double) width * height);
+    }
+
+    bool Game::is_alive(const hlt::PlayerId player_id) const {
+        return !players[player_id].ejected && !state.ships.at(player_id).empty();
+    }
+
+    bool Game::is_over() const {
+        if (turn() >= max_turns) {
+            return true;
+        }
+        int alive = 0;
+        for (hlt::PlayerId player_id = 0; player_id < num_players(); ++player_id) {
+            alive += is_alive(player_id);
+        }
+        return alive <= 1;
+    }
+
+    std::string Game::frame() const {
+        return write_frame(state);
+    }
+
+    void Game::eject(const hlt::PlayerId player_id) {
+        players[player_id].ejected = true;
+        for (hlt::ForwardState::ShipState& ship : model_state.ships) {
+            if (ship.owner_id == player_id) {
+                ship.health = 0;
+            }
+        }
+        hlt::ForwardModel::remove_dead(model_state);
+        model_state.to_map(state);
+    }
+
+    void Game::step(const std::vector<std::vector<hlt::Move>>& moves) {
+        model.step(model_state, moves);
+        model_state.to_map(state);
+
+        for (hlt::PlayerId player_id = 0; player_id < num_players(); ++player_id) {
+            if (is_alive(player_id)) {
+                players[player_id].last_turn_alive = turn();
+            }
+        }
+    }
+
+    std::vector<PlayerResult> Game::results() const {
+        std::vector<PlayerResult> results;
+        for (hlt::PlayerId player_id = 0; player_id < num_players(); ++player_id) {
+            PlayerResult result = { player_id, 0, players[player_id].last_turn_alive, 0, 0, players[player_id].ejected };
+            for (const hlt::Ship& ship : state.ships.at(player_id)) {
+                ++result.ships;
+                result.total_health += ship.health;
+            }
+            results.push_back(result);
+        }
+
+        std::stable_sort(results.begin(), results.end(), [](const PlayerResult& a, const PlayerResult& b) {
+            if (a.last_turn_alive != b.last_turn_alive) {
+                return a.last_turn_alive > b.last_turn_alive;
+            }
+            if (a.ships != b.ships) {
+                return a.ships > b.ships;
+            }
+            return a.total_health > b.total_health;
+        });
+        for (size_t i = 0; i < results.size(); ++i) {
+            results[i].rank = (int) i + 1;
+        }
+        return results;
+    }
+}
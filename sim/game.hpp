@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "hlt/forward_model.hpp"
+#include "hlt/map.hpp"
+#include "hlt/move.hpp"
+
+namespace sim {
+    /// Final standing of one player.
+    struct PlayerResult {
+        hlt::PlayerId player_id;
+        /// 1 is the winner.
+        int rank;
+        /// The last turn the player still had ships.
+        int last_turn_alive;
+        int ships;
+        int total_health;
+        bool ejected;
+    };
+
+    /**
+     * Headless Halite II game: runs the rules of hlt::ForwardModel from an
+     * initial map to the end, keeping track of ejected players and of when
+     * each player was last alive. How the commands are obtained (bot
+     * processes, in-process bots) is up to the caller. Invalid commands are
+     * ignored rather than ejecting the player.
+     */
+    class Game {
+    public:
+        Game(hlt::Map initial_map, int num_players, int max_turns);
+
+        /// The engine's turn limit for a map of this size.
+        static int default_max_turns(int width, int height);
+
+        const hlt::Map& map() const {
+            return state;
+        }
+
+        /// The same state in the forward model's layout, e.g. to look ahead from.
+        const hlt::ForwardState& forward_state() const {
+            return model_state;
+        }
+
+        int turn() const {
+            return model_state.turn;
+        }
+
+        int num_players() const {
+            return (int) players.size();
+        }
+
+        bool is_alive(hlt::PlayerId player_id) const;
+        bool is_over() const;
+
+        /// The map as the engine sends it to the bots this turn.
+        std::string frame() const;
+
+        /// Remove a player from the game, e.g. for a timeout or a malformed reply.
+        void eject(hlt::PlayerId player_id);
+
+        /// Advance one turn. moves[player_id] holds that player's commands.
+        void step(const std::vector<std::vector<hlt::Move>>& moves);
+
+        /// Players by rank: last turn alive, then ships, then total health.
+        std::vector<PlayerResult> results() const;
+
+    private:
+        struct PlayerState {
+            int last_turn_alive;
+            bool ejected;
+        };
+
+        /// model_state as a map, for map() and frame().
+        hlt::Map state;
+        hlt::ForwardState model_state;
+        hlt::ForwardModel model;
+        std::vector<PlayerState> players;
+        int max_turns;
+    };
+}
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hlt/turn_timer.hpp"
+#include "hlt/worker_pool.hpp"
+#include "sim/game.hpp"
+#include "sim/map_generator.hpp"
+#include "strategies/registry.hpp"
+
+namespace {
+    /// Everything recorded for one bot of the lineup.
+    struct BotStats {
+        std::string label;
+        strategies::StrategyFactory factory;
+        int games = 0;
+        int wins = 0;
+        long rank_sum = 0;
+        int errors = 0;
+        std::vector<float> turn_ms;
+    };
+
+    void usage() {
+        std::fprintf(stderr,
+                     "usage: halite_batch [-g GAMES] [-j THREADS] [-d \"WIDTH HEIGHT\"] [-s SEED] [-n TURNS] BOT BOT [BOT BOT]\n"
+                     "  -g  games to play, default 100\n"
+                     "  -j  worker threads, default one per core\n"
+                     "  -d  map size, default \"240 160\"\n"
+                     "  -s  seed of the first game, default 1; game i uses SEED + i\n"
+                     "  -n  turn limit, default the engine's for the map size\n"
+                     "Plays 2 or 4 linked-in strategies against each other, rotating seats every game.\n"
+                     "Strategies:");
+        for (const strategies::NamedStrategy& strategy : strategies::STRATEGIES) {
+            std::fprintf(stderr, " %s", strategy.name);
+        }
+        std::fprintf(stderr, "\n");
+    }
+
+    double percentile(std::vector<float>& samples, const double fraction) {
+        if (samples.empty()) {
+            return 0;
+        }
+        const size_t index = std::min(samples.size() - 1, (size_t) (fraction * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+
+    /**
+     * Play one game in this thread. Seat p is taken by bot (p + game_index) %
+     * num_players, so every bot plays every starting position equally often.
+     */
+    void play_game(
+            const int game_index,
+            const unsigned int seed,
+            const int width,
+            const int height,
+            const int max_turns,
+            std::vector<BotStats>& stats,
+            std::mutex& stats_mutex)
+    {
+        const int num_players = (int) stats.size();
+        sim::Game game(sim::generator::generate_map(width, height, num_players, seed), num_players, max_turns);
+
+        std::vector<size_t> bot_of_seat((size_t) num_players);
+        std::vector<strategies::Strategy> seats;
+        for (hlt::PlayerId player_id = 0; player_id < num_players; ++player_id) {
+            bot_of_seat[player_id] = (size_t) ((player_id + game_index) % num_players);
+            seats.push_back(stats[bot_of_seat[player_id]].factory(player_id, game.map()));
+        }
+
+        std::vector<std::vector<float>> turn_ms((size_t) num_players);
+        std::vector<int> errors((size_t) num_players, 0);
+        std::vector<std::vector<hlt::Move>> moves((size_t) num_players);
+        while (!game.is_over()) {
+            for (hlt::PlayerId player_id = 0; player_id < num_players; ++player_id) {
+                moves[player_id].clear();
+                if (!game.is_alive(player_id)) {
+                    continue;
+                }
+                hlt::TurnTimer::start(hlt::constants::TURN_TIME_LIMIT_MS);
+                try {
+                    seats[player_id](game.map(), moves[player_id]);
+                } catch (const std::exception& e) {
+                    moves[player_id].clear();
+                    std::fprintf(stderr, "game %d: %s threw: %s\n",
+                                 game_index, stats[bot_of_seat[player_id]].label.c_str(), e.what());
+                    ++errors[player_id];
+                    game.eject(player_id);
+                }
+                turn_ms[player_id].push_back((float) hlt::TurnTimer::elapsed_ms());
+            }
+            game.step(moves);
+        }
+
+        const std::vector<sim::PlayerResult> results = game.results();
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        for (const sim::PlayerResult& result : results) {
+            BotStats& bot = stats[bot_of_seat[result.player_id]];
+            ++bot.games;
+            bot.wins += result.rank == 1;
+            bot.rank_sum += result.rank;
+            bot.errors += errors[result.player_id];
+            bot.turn_ms.insert(bot.turn_ms.end(), turn_ms[result.player_id].begin(), turn_ms[result.player_id].end());
+        }
+    }
+}
+
+/**
+ * Batch A/B harness: plays many games in-process on a thread pool, with the
+ * bots linked in as strategies::Strategy functions instead of processes, and
+ * reports win rate and turn times per bot.
+ */
+int main(int argc, char** argv) {
+    int games = 100;
+    int threads = (int) std::max(1u, std::thread::hardware_concurrency());
+    int width = 240;
+    int height = 160;
+    unsigned int first_seed = 1;
+    int max_turns = -1;
+    std::vector<std::string> names;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-g" && i + 1 < argc) {
+            games = std::atoi(argv[++i]);
+        } else if (arg == "-j" && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-d" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%d %d", &width, &height) != 2) {
+                usage();
+                return 1;
+            }
+        } else if (arg == "-s" && i + 1 < argc) {
+            first_seed = (unsigned int) std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "-n" && i + 1 < argc) {
+            max_turns = std::atoi(argv[++i]);
+        } else if (!arg.empty() && arg[0] == '-') {
+            usage();
+            return 1;
+        } else {
+            names.push_back(arg);
+        }
+    }
+    if (names.size() != 2 && names.size() != 4) {
+        usage();
+        return 1;
+    }
+    if (max_turns < 0) {
+        max_turns = sim::Game::default_max_turns(width, height);
+    }
+
+    std::vector<BotStats> stats(names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        stats[i].factory = strategies::find_strategy(names[i]);
+        if (!stats[i].factory) {
+            std::fprintf(stderr, "unknown strategy: %s\n", names[i].c_str());
+            usage();
+            return 1;
+        }
+        const bool repeated = std::count(names.begin(), names.end(), names[i]) > 1;
+        stats[i].label = repeated ? names[i] + "#" + std::to_string(i + 1) : names[i];
+    }
+
+    // Games already run side by side; a pool per bot on top would only oversubscribe the cores.
+    hlt::WorkerPool::set_default_threads(1);
+
+    const auto started = std::chrono::steady_clock::now();
+    std::atomic<int> next_game(0);
+    std::mutex stats_mutex;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < std::min(threads, games); ++t) {
+        workers.emplace_back([&]() {
+            for (int game = next_game++; game < games; game = next_game++) {
+                play_game(game, first_seed + (unsigned int) game, width, height, max_turns, stats, stats_mutex);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+
+    std::printf("%d games, map %dx%d, %d players, %d threads, %.1f s\n",
+                games, width, height, (int) names.size(), (int) workers.size(), elapsed.count());
+    std::printf("%-26s %6s %6s %9s %7s %9s %13s %12s %7s\n",
+                "bot", "games", "wins", "win rate", "+/-95%", "mean rank", "mean turn ms", "p99 turn ms", "errors");
+    for (BotStats& bot : stats) {
+        const double win_rate = bot.games > 0 ? (double) bot.wins / bot.games : 0;
+        const double margin = bot.games > 0 ? 1.96 * std::sqrt(win_rate * (1 - win_rate) / bot.games) : 0;
+        double total_ms = 0;
+        for (const float ms : bot.turn_ms) {
+            total_ms += ms;
+        }
+        const double mean_ms = bot.turn_ms.empty() ? 0 : total_ms / bot.turn_ms.size();
+        std::printf("%-26s %6d %6d %8.1f%% %6.1f%% %9.2f %13.3f %12.3f %7d\n",
+                    bot.label.c_str(), bot.games, bot.wins, 100 * win_rate, 100 * margin,
+                    bot.games > 0 ? (double) bot.rank_sum / bot.games : 0, mean_ms,
+                    percentile(bot.turn_ms, 0.99), bot.errors);
+    }
+    return 0;
+}
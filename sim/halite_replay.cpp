@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "hlt/hlt_in.hpp"
+#include "hlt/hlt_out.hpp"
+#include "hlt/profile.hpp"
+#include "hlt/replay.hpp"
+#include "hlt/turn_timer.hpp"
+#include "hlt/worker_pool.hpp"
+#include "hlt/world.hpp"
+#include "strategies/registry.hpp"
+
+namespace {
+    void usage() {
+        std::fprintf(stderr,
+                     "usage: halite_replay [-b BOT] [-r ROUNDS] [-j THREADS] [-p PREFIX] [-v] RECORDING\n"
+                     "  -b  strategy to replay the frames through, default my_bot\n"
+                     "  -r  times to replay the game, default 1; turn times are the best of all rounds\n"
+                     "  -j  worker threads of the strategy, default one per core\n"
+                     "  -p  write the hot-path profile of the first round to PREFIX.csv and PREFIX.txt,\n"
+                     "      in builds with HLT_PROFILE\n"
+                     "  -v  print every turn\n"
+                     "Feeds the frames of a game recorded with HLT_RECORD=DIR back through a\n"
+                     "linked-in strategy, timing each turn, and checks the moves against the recording.\n"
+                     "Strategies:");
+        for (const strategies::NamedStrategy& strategy : strategies::STRATEGIES) {
+            std::fprintf(stderr, " %s", strategy.name);
+        }
+        std::fprintf(stderr, "\n");
+    }
+
+    double elapsed_ms(const std::chrono::steady_clock::time_point since) {
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - since;
+        return elapsed.count();
+    }
+
+    struct TurnTime {
+        double update_ms;
+        double strategy_ms;
+
+        double total_ms() const {
+            return update_ms + strategy_ms;
+        }
+    };
+
+    /// One pass over the game, the way strategies::play runs it: parse_map before the game, then World.
+    double replay_game(
+            const hlt::replay::Recording& recording,
+            const strategies::StrategyFactory& factory,
+            std::vector<TurnTime>& times,
+            std::vector<bool>* matches) {
+        const hlt::replay::Header& header = recording.header;
+
+        auto started = std::chrono::steady_clock::now();
+        hlt::TurnTimer::start(hlt::constants::PREGAME_TIME_LIMIT_MS);
+        strategies::Strategy strategy;
+        {
+            HLT_PROFILE_SCOPE(Strategy);
+            strategy = factory(header.player_id,
+                               hlt::in::parse_map(recording.pregame_frame, header.map_width, header.map_height));
+        }
+        const double pregame_ms = elapsed_ms(started);
+        hlt::profile::Profiler::end_turn();
+
+        hlt::World world(header.map_width, header.map_height);
+        std::vector<hlt::Move> moves;
+        hlt::out::MoveEncoder encoder;
+        for (size_t turn = 0; turn < recording.turns.size(); ++turn) {
+            started = std::chrono::steady_clock::now();
+            hlt::TurnTimer::start(hlt::constants::TURN_TIME_LIMIT_MS);
+            world.update(recording.turns[turn].frame);
+            const double update_ms = elapsed_ms(started);
+
+            moves.clear();
+            {
+                HLT_PROFILE_SCOPE(Strategy);
+                strategy(world.map(), moves);
+            }
+            const double total_ms = elapsed_ms(started);
+            hlt::profile::Profiler::end_turn();
+
+            times[turn].update_ms = std::min(times[turn].update_ms, update_ms);
+            times[turn].strategy_ms = std::min(times[turn].strategy_ms, total_ms - update_ms);
+
+            if (matches != nullptr) {
+                encoder.encode(moves);
+                const std::string& recorded = recording.turns[turn].moves;
+                (*matches)[turn] = recording.turns[turn].answered && encoder.size() == recorded.size() + 1
+                                   && std::equal(recorded.begin(), recorded.end(), encoder.data());
+            }
+        }
+        return pregame_ms;
+    }
+
+    double percentile(std::vector<double> samples, const double fraction) {
+        if (samples.empty()) {
+            return 0;
+        }
+        const size_t index = std::min(samples.size() - 1, (size_t) (fraction * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+}
+
+/**
+ * Replay-driven benchmark: runs a strategy over the exact frames a bot saw
+ * in a recorded game, so slow turns from real games can be reproduced and
+ * timed on a fixed workload.
+ */
+int main(int argc, char** argv) {
+    std::string bot = "my_bot";
+    int rounds = 1;
+    bool verbose = false;
+    std::string profile_prefix;
+    std::string filename;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-b" && i + 1 < argc) {
+            bot = argv[++i];
+        } else if (arg == "-r" && i + 1 < argc) {
+            rounds = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-j" && i + 1 < argc) {
+            hlt::WorkerPool::set_default_threads(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "-p" && i + 1 < argc) {
+            profile_prefix = argv[++i];
+        } else if (arg == "-v") {
+            verbose = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            usage();
+            return 1;
+        } else if (filename.empty()) {
+            filename = arg;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (filename.empty()) {
+        usage();
+        return 1;
+    }
+    const strategies::StrategyFactory factory = strategies::find_strategy(bot);
+    if (!factory) {
+        std::fprintf(stderr, "unknown strategy: %s\n", bot.c_str());
+        usage();
+        return 1;
+    }
+
+    hlt::replay::Recording recording;
+    std::string error;
+    if (!hlt::replay::load(filename, recording, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    const size_t num_turns = recording.turns.size();
+
+    const double never = 1e300;
+    std::vector<TurnTime> times(num_turns, TurnTime{ never, never });
+    std::vector<bool> matches(num_turns, false);
+    double pregame_ms = never;
+    if (!profile_prefix.empty()) {
+        if (!hlt::profile::Profiler::compiled()) {
+            std::fprintf(stderr, "-p needs a build with HLT_PROFILE on\n");
+            return 1;
+        }
+        hlt::profile::Profiler::open(profile_prefix);
+    }
+    for (int round = 0; round < rounds; ++round) {
+        pregame_ms = std::min(pregame_ms, replay_game(recording, factory, times, round == 0 ? &matches : nullptr));
+        if (round == 0 && !profile_prefix.empty()) {
+            hlt::profile::Profiler::write();
+        }
+    }
+
+    std::vector<double> totals;
+    double update_sum = 0;
+    double strategy_sum = 0;
+    for (size_t turn = 0; turn < num_turns; ++turn) {
+        totals.push_back(times[turn].total_ms());
+        update_sum += times[turn].update_ms;
+        strategy_sum += times[turn].strategy_ms;
+        if (verbose) {
+            std::printf("turn %4d %8.3f ms (update %7.3f, strategy %8.3f)%s\n", (int) turn + 1,
+                        times[turn].total_ms(), times[turn].update_ms, times[turn].strategy_ms,
+                        matches[turn] ? "" : " moves differ");
+        }
+    }
+
+    std::printf("%s: player %d (%s), map %dx%d, %d turns, replayed through %s, best of %d\n",
+                filename.c_str(), (int) recording.header.player_id, recording.header.bot_name.c_str(),
+                recording.header.map_width, recording.header.map_height, (int) num_turns, bot.c_str(), rounds);
+    if (num_turns == 0) {
+        return 0;
+    }
+    std::printf("pre-game %.3f ms | turn mean %.3f ms (update %.3f, strategy %.3f), p50 %.3f, p90 %.3f, p99 %.3f ms\n",
+                pregame_ms, (update_sum + strategy_sum) / num_turns, update_sum / num_turns, strategy_sum / num_turns,
+                percentile(totals, 0.5), percentile(totals, 0.9), percentile(totals, 0.99));
+
+    std::vector<size_t> slowest(num_turns);
+    for (size_t turn = 0; turn < num_turns; ++turn) {
+        slowest[turn] = turn;
+    }
+    const size_t shown = std::min<size_t>(5, num_turns);
+    std::partial_sort(slowest.begin(), slowest.begin() + shown, slowest.end(), [&](const size_t a, const size_t b) {
+        return totals[a] > totals[b];
+    });
+    std::printf("slowest turns:");
+    for (size_t i = 0; i < shown; ++i) {
+        std::printf(" %d (%.3f ms)", (int) slowest[i] + 1, totals[slowest[i]]);
+    }
+    std::printf("\n");
+
+    const long matching = std::count(matches.begin(), matches.end(), true);
+    std::printf("moves match the recording on %ld/%d turns\n", matching, (int) num_turns);
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hlt/constants.hpp"
+#include "sim/bot_process.hpp"
+#include "sim/frame.hpp"
+#include "sim/game.hpp"
+#include "sim/map_generator.hpp"
+
+namespace {
+    void usage() {
+        std::fprintf(stderr,
+                     "usage: halite_sim [-d \"WIDTH HEIGHT\"] [-s SEED] [-n TURNS] [-t] BOT_COMMAND BOT_COMMAND [...]\n"
+                     "  -d  map size, default \"240 160\"\n"
+                     "  -s  map seed, default from the clock\n"
+                     "  -n  turn limit, default the engine's for the map size\n"
+                     "  -t  no time limits\n"
+                     "Runs 2 or 4 bots over stdin/stdout and prints the final ranking.\n");
+    }
+
+    double elapsed_ms(const std::chrono::steady_clock::time_point since) {
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - since;
+        return elapsed.count();
+    }
+}
+
+/**
+ * Headless stand-in for the Halite II engine: plays one game between bot
+ * processes using sim::Game, as fast as the bots answer.
+ */
+int main(int argc, char** argv) {
+    int width = 240;
+    int height = 160;
+    unsigned int seed = (unsigned int) std::chrono::system_clock::now().time_since_epoch().count();
+    int max_turns = -1;
+    bool timeouts = true;
+    std::vector<std::string> commands;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-d" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%d %d", &width, &height) != 2) {
+                usage();
+                return 1;
+            }
+        } else if (arg == "-s" && i + 1 < argc) {
+            seed = (unsigned int) std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "-n" && i + 1 < argc) {
+            max_turns = std::atoi(argv[++i]);
+        } else if (arg == "-t") {
+            timeouts = false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            usage();
+            return 1;
+        } else {
+            commands.push_back(arg);
+        }
+    }
+    if (commands.size() != 2 && commands.size() != 4) {
+        usage();
+        return 1;
+    }
+
+    // A bot that dies mid-write must not take the simulator down with it.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const int num_players = (int) commands.size();
+    if (max_turns < 0) {
+        max_turns = sim::Game::default_max_turns(width, height);
+    }
+    sim::Game game(sim::generator::generate_map(width, height, num_players, seed), num_players, max_turns);
+
+    std::vector<std::unique_ptr<sim::BotProcess>> bots;
+    std::vector<std::string> names(commands.size());
+    const auto eject = [&](const hlt::PlayerId player_id, const char* reason) {
+        std::fprintf(stderr, "turn %d: player %d (%s) ejected: %s\n",
+                     game.turn(), player_id, names[player_id].c_str(), reason);
+        game.eject(player_id);
+        bots[player_id]->stop();
+    };
+
+    const std::string initial_frame = game.frame();
+    for (hlt::PlayerId player_id = 0; player_id < num_players; ++player_id) {
+        names[player_id] = commands[player_id];
+        bots.emplace_back(new sim::BotProcess(commands[player_id]));
+        sim::BotProcess& bot = *bots.back();
+        bot.send_line(std::to_string(player_id));
+        bot.send_line(std::to_string(width) + " " + std::to_string(height));
+        bot.send_line(initial_frame);
+    }
+    for (hlt::PlayerId player_id = 0; player_id < num_players; ++player_id) {
+        const int limit = timeouts ? hlt::constants::PREGAME_TIME_LIMIT_MS : -1;
+        if (!bots[player_id]->read_line(names[player_id], limit)) {
+            eject(player_id, "no name before the pre-game deadline");
+        }
+    }
+
+    std::vector<std::vector<hlt::Move>> moves((size_t) num_players);
+    std::string reply;
+    while (!game.is_over()) {
+        const std::string frame = game.frame();
+        for (hlt::PlayerId player_id = 0; player_id < num_players; ++player_id) {
+            moves[player_id].clear();
+            if (game.is_alive(player_id) && !bots[player_id]->send_line(frame)) {
+                eject(player_id, "closed its input");
+            }
+        }
+
+        // Bots think in parallel; each one's clock runs from the moment the frames went out.
+        const auto sent = std::chrono::steady_clock::now();
+        for (hlt::PlayerId player_id = 0; player_id < num_players; ++player_id) {
+            if (!game.is_alive(player_id)) {
+                continue;
+            }
+            const int limit = timeouts ? std::max(0, hlt::constants::TURN_TIME_LIMIT_MS - (int) elapsed_ms(sent)) : -1;
+            if (!bots[player_id]->read_line(reply, limit)) {
+                eject(player_id, "no moves before the deadline");
+            } else if (!sim::parse_moves(reply, moves[player_id])) {
+                eject(player_id, "malformed moves");
+            }
+        }
+
+        game.step(moves);
+    }
+
+    for (const std::unique_ptr<sim::BotProcess>& bot : bots) {
+        bot->stop();
+    }
+
+    std::printf("map %dx%d, seed %u, %d turns\n", width, height, seed, game.turn());
+    for (const sim::PlayerResult& result : game.results()) {
+        std::printf("#%d player %d %s: %d ships, %d health, alive until turn %d%s\n",
+                    result.rank, result.player_id, names[result.player_id].c_str(), result.ships,
+                    result.total_health, result.last_turn_alive, result.ejected ? " (ejected)" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "hlt/map.hpp"
+
+namespace sim {
+    namespace generator {
+        constexpr int SHIPS_PER_PLAYER = 3;
+        constexpr double MIN_PLANET_RADIUS = 3.0;
+        constexpr double MAX_PLANET_RADIUS = 8.0;
+        constexpr int PLANET_HEALTH_PER_RADIUS = 255;
+        constexpr int PRODUCTION_PER_RADIUS = 100;
+
+        /** Free space kept between planets, and between a planet and a starting fleet */
+        constexpr double PLANET_GAP = 6.0;
+        constexpr double START_CLEARANCE = 12.0;
+
+        /// Map area per group of mirrored planets.
+        constexpr double AREA_PER_PLANET_GROUP = 7680.0;
+
+        /**
+         * The images of a point under the map's symmetry, one per player.
+         * Two players mirror through the center, four mirror across both axes.
+         */
+        static std::vector<hlt::Location> images(const hlt::Location& location, const int width, const int height, const int num_players) {
+            const double x = location.pos_x;
+            const double y = location.pos_y;
+            if (num_players == 2) {
+                return { { x, y }, { width - x, height - y } };
+            }
+            return { { x, y }, { width - x, y }, { x, height - y }, { width - x, height - y } };
+        }
+
+        /**
+         * Generate a symmetric starting map: each player gets SHIPS_PER_PLAYER
+         * ships at the image of the same starting point, and planets are
+         * placed in mirrored groups so no player is favored.
+         */
+        static hlt::Map generate_map(const int width, const int height, const int num_players, const unsigned int seed) {
+            if (num_players != 2 && num_players != 4) {
+                throw std::invalid_argument("the simulator supports 2 or 4 players");
+            }
+
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+            hlt::Map map(width, height);
+
+            const hlt::Location first_start = num_players == 2
+                    ? hlt::Location{ width * 0.25, height * 0.5 }
+                    : hlt::Location{ width * 0.25, height * 0.25 };
+            const std::vector<hlt::Location> starts = images(first_start, width, height, num_players);
+
+            const int groups = std::max(2, (int) (width * height / AREA_PER_PLANET_GROUP) * 2 / num_players);
+            for (int attempt = 0; attempt < groups * 100 && (int) map.planets.size() < groups * num_players; ++attempt) {
+                const double radius = MIN_PLANET_RADIUS + unit(rng) * (MAX_PLANET_RADIUS - MIN_PLANET_RADIUS);
+                const double margin = radius + hlt::constants::SPAWN_RADIUS + 2;
+                const hlt::Location candidate = {
+                        margin + unit(rng) * (width - 2 * margin),
+                        margin + unit(rng) * (height - 2 * margin),
+                };
+                const std::vector<hlt::Location> group = images(candidate, width, height, num_players);
+
+                bool fits = true;
+                for (size_t i = 0; i < group.size() && fits; ++i) {
+                    for (size_t j = i + 1; j < group.size() && fits; ++j) {
+                        fits = group[i].get_distance_to(group[j]) >= 2 * radius + PLANET_GAP;
+                    }
+                    for (const hlt::Planet& other : map.planets) {
+                        fits = fits && group[i].get_distance_to(other.location) >= radius + other.radius + PLANET_GAP;
+                    }
+                    for (const hlt::Location& start : starts) {
+                        fits = fits && group[i].get_distance_to(start) >= radius + START_CLEARANCE;
+                    }
+                }
+                if (!fits) {
+                    continue;
+                }
+
+                const double size = (radius - MIN_PLANET_RADIUS) / (MAX_PLANET_RADIUS - MIN_PLANET_RADIUS);
+                for (const hlt::Location& location : group) {
+                    hlt::Planet planet;
+                    planet.entity_id = (hlt::EntityId) map.planets.size();
+                    planet.owner_id = -1;
+                    planet.owned = false;
+                    planet.location = location;
+                    planet.radius = radius;
+                    planet.health = (int) (radius * PLANET_HEALTH_PER_RADIUS);
+                    planet.docking_spots = 2 + (unsigned int) std::lround(size * 4);
+                    planet.current_production = 0;
+                    planet.remaining_production = (int) (radius * PRODUCTION_PER_RADIUS);
+                    map.planet_map[planet.entity_id] = (unsigned int) map.planets.size();
+                    map.planets.push_back(planet);
+                }
+            }
+
+            hlt::EntityId next_ship_id = 0;
+            for (hlt::PlayerId player_id = 0; player_id < num_players; ++player_id) {
+                std::vector<hlt::Ship>& ships = map.ships[player_id];
+                hlt::entity_map<unsigned int>& ship_map = map.ship_map[player_id];
+                for (int i = 0; i < SHIPS_PER_PLAYER; ++i) {
+                    hlt::Ship ship;
+                    ship.entity_id = next_ship_id++;
+                    ship.owner_id = player_id;
+                    ship.location = { starts[player_id].pos_x, starts[player_id].pos_y + 2.0 * (i - 1) };
+                    ship.health = hlt::constants::BASE_SHIP_HEALTH;
+                    ship.radius = hlt::constants::SHIP_RADIUS;
+                    ship.weapon_cooldown = 0;
+                    ship.docking_status = hlt::ShipDockingStatus::Undocked;
+                    ship.docking_progress = 0;
+                    ship.docked_planet = 0;
+                    ship_map[ship.entity_id] = (unsigned int) ships.size();
+                    ships.push_back(ship);
+                }
+            }
+
+            return map;
+        }
+    }
+}
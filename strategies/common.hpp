@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "hlt/distance_cache.hpp"
+#include "hlt/flow_field.hpp"
+#include "hlt/move_planner.hpp"
+#include "hlt/turn_timer.hpp"
+#include "hlt/visibility_graph.hpp"
+#include "strategies/strategy.hpp"
+
+namespace strategies {
+    /// Pieces the planner-driven bots share.
+    namespace common {
+        using namespace hlt;
+
+        /**
+         * The ways around the planets that a bot shares with its planner: the
+         * visibility graph, and the fields towards every planet. Planets never
+         * move, so both are worked out before the first turn, and only again
+         * once a planet is destroyed.
+         */
+        struct Routes {
+            std::shared_ptr<VisibilityGraph> graph;
+            std::shared_ptr<FlowFields> flows;
+
+            /// Work them out for initial_map and hand them to planner.
+            Routes(MovePlanner& planner, const Map& initial_map) :
+                    graph(std::make_shared<VisibilityGraph>(initial_map)),
+                    flows(std::make_shared<FlowFields>(initial_map))
+            {
+                HLT_LOG(Info, "route graph: " << graph->num_nodes() << " nodes, " << graph->num_edges() << " edges");
+                planner.set_routes(graph);
+                planner.set_flow_fields(flows);
+            }
+
+            /// Bring both up to date with map, for player_id, before the planner runs.
+            void begin_turn(const Map& map, const PlayerId player_id) {
+                if (graph->update(map)) {
+                    HLT_LOG(Info, "route graph rebuilt: " << graph->num_nodes() << " nodes, " << graph->num_edges() << " edges");
+                }
+                flows->begin_turn(map, player_id);
+            }
+        };
+
+        /**
+         * Enemy ships close together, so that the ships going after one
+         * group can share a single field from FlowFields::toward(). A ship
+         * joins the first group whose first ship is within GROUP_RADIUS of it.
+         *
+         * A field only pays off when it is shared, so only the groups most
+         * ships head for get one, only if at least MIN_SHARED do, and only
+         * while the turn budget lasts.
+         * assign(), head_for() and build_fields() run on one thread, as the
+         * fields are built then; field_of() only reads.
+         */
+        class EnemyGroups {
+        public:
+            /// Enemies within this of the first ship of a group join it.
+            static constexpr double GROUP_RADIUS = 2 * constants::WEAPON_RADIUS;
+            /// The most groups given a field each turn: each is a fast marching pass over the map.
+            static constexpr size_t MAX_FIELDS = 3;
+            /// How many ships must head for a group before it gets a field.
+            static constexpr int MIN_SHARED = 2;
+
+            /// Group the enemies of player_id on map, only the docked ones if docked_only.
+            void assign(const Map& map, const PlayerId player_id, const bool docked_only) {
+                groups.clear();
+                for (const auto& player_ships : map.ships) {
+                    if (player_ships.first == player_id) {
+                        continue;
+                    }
+                    for (const Ship& enemy : player_ships.second) {
+                        if (docked_only && enemy.docking_status == ShipDockingStatus::Undocked) {
+                            continue;
+                        }
+                        add(enemy);
+                    }
+                }
+            }
+
+            void clear() {
+                groups.clear();
+            }
+
+            /// Count one more ship headed for the group of enemy.
+            void head_for(const Ship& enemy) {
+                Group* group = find(enemy);
+                if (group != nullptr) {
+                    ++group->ships;
+                }
+            }
+
+            /**
+             * Build the fields of the groups most ships head for, and forget
+             * the others. Each field is a pass over the whole map, so no more
+             * are built once the turn budget runs low.
+             */
+            void build_fields(FlowFields& flows) {
+                // Ties go to the group found first; with that key a plain sort is stable, and unlike
+                // std::stable_sort it needs no temporary buffer.
+                std::sort(groups.begin(), groups.end(), [](const Group& a, const Group& b) {
+                    return a.ships > b.ships || (a.ships == b.ships && a.found < b.found);
+                });
+                size_t count = 0;
+                while (count < groups.size() && count < MAX_FIELDS && groups[count].ships >= MIN_SHARED
+                       && TurnTimer::budget() == TurnBudget::Full) {
+                    groups[count].field = &flows.toward(groups[count].center, groups[count].radius);
+                    ++count;
+                }
+                groups.resize(count);
+            }
+
+            /// The field towards the group enemy is in, or nullptr.
+            const FlowField* field_of(const Ship& enemy) const {
+                for (const Group& group : groups) {
+                    if (group.center.get_distance_to(enemy.location) <= group.radius) {
+                        return group.field;
+                    }
+                }
+                return nullptr;
+            }
+
+        private:
+            struct Group {
+                /// Where the group's first ship is.
+                Location center;
+                /// How far from center the group's ships reach.
+                double radius;
+                /// Ships headed for the group.
+                int ships;
+                /// How many groups were found before this one.
+                unsigned int found;
+                const FlowField* field;
+            };
+
+            std::vector<Group> groups;
+
+            Group* find(const Ship& enemy) {
+                for (Group& group : groups) {
+                    if (group.center.get_distance_to(enemy.location) <= group.radius) {
+                        return &group;
+                    }
+                }
+                return nullptr;
+            }
+
+            void add(const Ship& enemy) {
+                for (Group& group : groups) {
+                    const double distance = group.center.get_distance_to(enemy.location);
+                    if (distance <= GROUP_RADIUS) {
+                        group.radius = std::max(group.radius, distance + enemy.radius);
+                        return;
+                    }
+                }
+                groups.push_back({ enemy.location, enemy.radius, 0, static_cast<unsigned int>(groups.size()), nullptr });
+            }
+        };
+
+        /**
+         * Add the docked enemies nearest to ship, until the planner's request
+         * for slot is full; along the field of their group, if groups has one.
+         */
+        static void add_docked_enemy_targets(MovePlanner& planner, const size_t slot, const Ship& ship, DistanceCache& distances,
+                                             const EnemyGroups* groups = nullptr) {
+            for (const Ship* enemy_ptr : distances.enemies_by_distance(ship)) {
+                if (!planner.wants_targets(slot)) {
+                    return;
+                }
+                if (enemy_ptr->docking_status != ShipDockingStatus::Undocked) {
+                    planner.add_dock_target(slot, *enemy_ptr, constants::MAX_SPEED,
+                                            groups != nullptr ? groups->field_of(*enemy_ptr) : nullptr);
+                }
+            }
+        }
+
+        /// What a miner does with one of the nearest planets it was not assigned.
+        enum class Fallback {
+            /// Add it as a target.
+            Take,
+            /// Leave it out and look at the next one.
+            Skip,
+            /// Leave it and all further planets out.
+            Stop,
+        };
+
+        /**
+         * Targets of an undocked miner whose request for slot the planner
+         * already holds: the planet assigned to it, else docked enemies first;
+         * then the nearest other planets, as rule(planet) has it, for the
+         * planner to fall back on, by the length of the way around the
+         * planets in graph; then docked enemies.
+         *
+         * When the ship can dock on its assigned planet right away, the
+         * request is cancelled and the dock move returned instead.
+         */
+        template<typename FallbackRule>
+        static possibly<Move> add_miner_targets(MovePlanner& planner, const size_t slot, const Ship& ship,
+                                                const Planet* assigned, DistanceCache& distances, const VisibilityGraph& graph,
+                                                FallbackRule rule) {
+            if (assigned != nullptr) {
+                if (ship.can_dock(*assigned)) {
+                    planner.cancel(slot);
+                    return { Move::dock(ship.entity_id, assigned->entity_id), true };
+                }
+                planner.add_dock_target(slot, *assigned, constants::MAX_SPEED);
+            } else {
+                // No free spot is left for this ship, so attack the nearest docked enemy ships
+                add_docked_enemy_targets(planner, slot, ship, distances);
+            }
+
+            // The nearest planets are only there for the planner to fall back on, the shortest way around the others first
+            const Planet* fallbacks[constants::MAX_PLANNED_TARGETS] = {};
+            double lengths[constants::MAX_PLANNED_TARGETS];
+            size_t num_fallbacks = 0;
+            for (const Planet* planet_ptr : distances.nearest_planets(ship, constants::MAX_PLANNED_TARGETS)) {
+                if (planet_ptr != assigned) {
+                    fallbacks[num_fallbacks++] = planet_ptr;
+                }
+            }
+            graph.path_lengths(ship.location, fallbacks, num_fallbacks, lengths);
+            // Insertion sort, so planets as far along keep their straight-line order.
+            for (size_t k = 1; k < num_fallbacks; ++k) {
+                for (size_t j = k; j > 0 && lengths[j] < lengths[j - 1]; --j) {
+                    std::swap(lengths[j], lengths[j - 1]);
+                    std::swap(fallbacks[j], fallbacks[j - 1]);
+                }
+            }
+
+            for (size_t k = 0; k < num_fallbacks; ++k) {
+                const Planet* planet_ptr = fallbacks[k];
+                const Fallback fallback = rule(*planet_ptr);
+                if (fallback == Fallback::Skip) {
+                    continue;
+                }
+                if (fallback == Fallback::Stop) {
+                    break;
+                }
+                if (!planner.wants_targets(slot)) {
+                    return { Move::noop(), false };
+                }
+                planner.add_dock_target(slot, *planet_ptr, constants::MAX_SPEED);
+            }
+            if (assigned != nullptr) {
+                // Otherwise attack the nearest docked enemy ships
+                add_docked_enemy_targets(planner, slot, ship, distances);
+            }
+            return { Move::noop(), false };
+        }
+    }
+}
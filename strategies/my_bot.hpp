@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+
+#include "hlt/assignment.hpp"
+#include "hlt/distance_cache.hpp"
+#include "hlt/entity_store.hpp"
+#include "hlt/flow_field.hpp"
+#include "hlt/move_planner.hpp"
+#include "hlt/threat_field.hpp"
+#include "hlt/worker_pool.hpp"
+#include "hlt/navigation.hpp"
+#include "strategies/common.hpp"
+#include "strategies/strategy.hpp"
+
+namespace strategies {
+    /**
+     * MyBot: a fraction of the ships (by id) are attackers that flee nearby
+     * enemies and harass docked ones; the rest are miners, which share the
+     * free docking spots out between them.
+     */
+    namespace my_bot {
+        using namespace std;
+        using namespace hlt;
+
+        const double RUN_AWAY_FROM_ENEMIES_WITHIN_RANGE = constants::WEAPON_RADIUS + constants::MAX_SPEED;
+
+        class Bot {
+        public:
+            Bot(const PlayerId player_id, const Map& initial_map) :
+                    player_id(player_id),
+                    workers(std::make_shared<WorkerPool>(WorkerPool::default_threads())),
+                    planner(workers),
+                    routes(planner, initial_map)
+            {
+                // Decide on number of attackers to miners
+                if(initial_map.ship_map.size() == 4){
+                    // Play a more econ game when there are a lot of players.
+                    DENOMINATOR_OF_FRACTION_OF_ATTACKER = 10000;
+                } else {
+                    // Calculate the proportion of attackers to miners based on map size; at least 1 on small maps
+                    DENOMINATOR_OF_FRACTION_OF_ATTACKER = std::max(1, 4 * ((initial_map.map_height * initial_map.map_width)/(240*160)));
+                }
+
+                // We now have 1 full minute to analyse the initial map.
+                HLT_LOG(Info, "width: " << initial_map.map_width
+                        << "; height: " << initial_map.map_height
+                        << "; players: " << initial_map.ship_map.size()
+                        << "; my ships: " << initial_map.ship_map.at(player_id).size()
+                        << "; planets: " << initial_map.planets.size());
+            }
+
+            void operator()(const Map& map, vector<Move>& moves) {
+                arena.reset();
+                HLT_LOG(Info, "New turn:" << turn++);
+                navigation::begin_turn(map);
+                routes.begin_turn(map, player_id);
+                entities.assign(map);
+                threats.compute(entities, player_id, RUN_AWAY_FROM_ENEMIES_WITHIN_RANGE);
+                DistanceCache distances(map, player_id, &arena);
+
+                const vector<Ship> &my_ships = map.ships.at(player_id);
+                // Out of time: the ships stay put so the moves still go out before the deadline.
+                // The planner also stops early, and navigation turns cheap once the budget runs low.
+                if (TurnTimer::budget() == TurnBudget::Exhausted) {
+                    HLT_LOG(Warning, "Turn budget exhausted; " << my_ships.size() << " ships left idle");
+                    return;
+                }
+
+                // Miners are given planets all at once, so no more of them head for a planet than it has room for...
+                assign_planets(map, my_ships);
+
+                // ...attackers going after the same group of enemies share one field towards it...
+                group_enemies(map, my_ships, distances);
+
+                // ...then each ship decides on its own, possibly on another thread, into its own slot...
+                planner.reset(my_ships.size());
+                decisions.assign(my_ships.size(), Decision());
+                workers->run(my_ships.size(), [&](const size_t i) {
+                    // Send a fraction of the ships to be attackers, and the rest to be miners
+                    if(is_attacker(my_ships[i])){
+                        // Be an attacker
+                        attacker(i, my_ships[i], distances);
+                    } else {
+                        // Be a miner
+                        miner(i, my_ships[i], distances);
+                    }
+                });
+
+                // ...and the decisions are merged in ship order.
+                for (size_t i = 0; i < my_ships.size(); ++i) {
+                    const Decision& decision = decisions[i];
+                    if (decision.attacker) {
+                        HLT_LOG(Debug, "ATTACKER");
+                    }
+                    if (decision.fleeing) {
+                        HLT_LOG(Debug, "NAVIGATE AWAY. LOCATION: " << " Average Radians:" << decision.flee_rads << " Away Radians:" << (decision.flee_rads));
+                    }
+                    if (decision.move.second) {
+                        moves.push_back(decision.move.first);
+                    }
+                }
+                planner.plan(map, moves);
+
+                HLT_LOG(Debug, "turn memory: " << arena.bytes_used() << " bytes, peak " << arena.peak_bytes() << " bytes");
+            }
+
+            /// The most scratch memory a turn has needed so far.
+            size_t peak_turn_bytes() const {
+                return arena.peak_bytes();
+            }
+
+        private:
+            /// What a ship decided this turn, apart from the targets it gave the planner.
+            struct Decision {
+                possibly<Move> move = { Move::noop(), false };
+                bool attacker = false;
+                bool fleeing = false;
+                double flee_rads = 0;
+            };
+
+            PlayerId player_id;
+            int DENOMINATOR_OF_FRACTION_OF_ATTACKER = 4;
+            int turn = 0;
+            vector<Decision> decisions;
+            EntityStore entities;
+            /// Enemies around each of my ships, by index into my ships.
+            ThreatField threats;
+            /// This turn's scratch, such as the distance tables.
+            Arena arena;
+            std::shared_ptr<WorkerPool> workers;
+            MovePlanner planner;
+            common::Routes routes;
+            PlanetAssignment assignment;
+            /// The enemies the attackers go after this turn.
+            common::EnemyGroups enemy_groups;
+            /// The undocked miners, in ship order, as given to the assignment.
+            vector<const Ship*> miner_ships;
+            /// Index into miner_ships of each of my ships, or -1.
+            vector<int> miner_index;
+
+            // Fleeing ships have the fewest ways out, so they pick their paths first.
+            static const int FLEE_PRIORITY = 0;
+            static const int MINER_PRIORITY = 1;
+            static const int ATTACKER_PRIORITY = 2;
+
+            bool is_attacker(const Ship& ship) const {
+                return ship.entity_id % DENOMINATOR_OF_FRACTION_OF_ATTACKER == 0;
+            }
+
+            void assign_planets(const Map& map, const vector<Ship>& my_ships) {
+                miner_ships.clear();
+                miner_index.assign(my_ships.size(), -1);
+                for (size_t i = 0; i < my_ships.size(); ++i) {
+                    if (!is_attacker(my_ships[i]) && my_ships[i].docking_status == ShipDockingStatus::Undocked) {
+                        miner_index[i] = static_cast<int>(miner_ships.size());
+                        miner_ships.push_back(&my_ships[i]);
+                    }
+                }
+                assignment.solve(map, player_id, miner_ships);
+            }
+
+            /**
+             * Group the enemies the attackers go after, and build a field towards
+             * the groups several of them head for first, if there is time to.
+             */
+            void group_enemies(const Map& map, const vector<Ship>& my_ships, DistanceCache& distances) {
+                enemy_groups.clear();
+                if (TurnTimer::budget() != TurnBudget::Full) {
+                    return;
+                }
+                // Attackers go after docked enemies while there are any, see attacker().
+                const bool docked_only = distances.has_docked_enemies();
+                enemy_groups.assign(map, player_id, docked_only);
+                for (size_t i = 0; i < my_ships.size(); ++i) {
+                    const Ship& ship = my_ships[i];
+                    if (!is_attacker(ship) || ship.docking_status != ShipDockingStatus::Undocked || threats[i].enemies > 0) {
+                        continue;
+                    }
+                    for (const Ship* enemy_ptr : distances.enemies_by_distance(ship)) {
+                        if (!docked_only || enemy_ptr->docking_status != ShipDockingStatus::Undocked) {
+                            enemy_groups.head_for(*enemy_ptr);
+                            break;
+                        }
+                    }
+                }
+                enemy_groups.build_fields(*routes.flows);
+            }
+
+            // Runs on worker threads: reads the turn's state, and only writes the ship's slot.
+            void miner(const size_t slot, const Ship &ship, DistanceCache &distances) {
+                if (ship.docking_status != hlt::ShipDockingStatus::Undocked) {
+                    return;
+                }
+                planner.request(slot, ship, MINER_PRIORITY);
+                const Planet* assigned = assignment.planet_of(miner_index[slot]);
+                decisions[slot].move = common::add_miner_targets(planner, slot, ship, assigned, distances, *routes.graph, [&](const Planet& planet) {
+                    // Skip over this planet if I own it and it is full
+                    if (planet.is_full() && planet.owned && planet.owner_id == player_id) {
+                        return common::Fallback::Skip;
+                    }
+                    if (ship.can_dock(planet) && planet.owned && planet.owner_id != player_id) {
+                        // Already at the planet, but currently someone else owns the planet. Thus, move to attacking
+                        return common::Fallback::Stop;
+                    }
+                    return common::Fallback::Take;
+                });
+            }
+
+            void attacker(const size_t slot, const Ship &ship, DistanceCache &distances) {
+                Decision& decision = decisions[slot];
+                decision.attacker = true;
+                if (ship.docking_status != hlt::ShipDockingStatus::Undocked) {
+                    decision.move = { Move::undock(ship.entity_id), true };
+                    return;
+                }
+
+                // Run away from nearby (within dangerous range) undocked enemy ships,
+                // away from the average direction (radians) of the enemies.
+                const Threat& threat = threats[slot];
+                if(threat.enemies > 0){
+                    double average_rads = threat.flee_rads;
+                    // Calculate run away direction
+                    Location run_away_loc = navigation::toLocation(
+                            ship.location, constants::MAX_SPEED, util::angle_rad_to_deg_clipped(average_rads));
+                    planner.request(slot, ship, FLEE_PRIORITY);
+                    planner.add_target(slot, run_away_loc, constants::MAX_SPEED);
+                    decision.fleeing = true;
+                    decision.flee_rads = average_rads;
+                    return;
+                }
+
+                // Attack nearest enemy ship
+                planner.request(slot, ship, ATTACKER_PRIORITY);
+                if(distances.has_docked_enemies()){
+                    // harass docked enemy ships, nearest first
+                    common::add_docked_enemy_targets(planner, slot, ship, distances, &enemy_groups);
+                }
+                else {
+                    // All enemy ships, nearest first
+                    for(const Ship* enemy_ptr: distances.nearest_enemies(ship, constants::MAX_PLANNED_TARGETS)) {
+                        planner.add_dock_target(slot, *enemy_ptr, hlt::constants::MAX_SPEED, enemy_groups.field_of(*enemy_ptr));
+                    }
+                }
+            }
+
+        };
+
+        static Strategy create(const PlayerId player_id, const Map& initial_map) {
+            return Bot(player_id, initial_map);
+        }
+    }
+}
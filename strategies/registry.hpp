@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+#include "strategies/my_bot.hpp"
+#include "strategies/simple_attack_and_miner.hpp"
+#include "strategies/strategy.hpp"
+#include "strategies/up_close.hpp"
+
+namespace strategies {
+    struct NamedStrategy {
+        const char* name;
+        StrategyFactory factory;
+    };
+
+    /// Every linked-in strategy, by the name the tools take on their command line.
+    static const NamedStrategy STRATEGIES[] = {
+            { "my_bot", my_bot::create },
+            { "simple_attack_and_miner", simple_attack_and_miner::create },
+            { "up_close", up_close::create },
+    };
+
+    /// The factory of the named strategy, or an empty one.
+    static StrategyFactory find_strategy(const std::string& name) {
+        for (const NamedStrategy& strategy : STRATEGIES) {
+            if (name == strategy.name) {
+                return strategy.factory;
+            }
+        }
+        return StrategyFactory();
+    }
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+
+#include "hlt/distance_cache.hpp"
+#include "hlt/navigation.hpp"
+#include "strategies/strategy.hpp"
+
+namespace strategies {
+    /**
+     * The simpler DivideAndConquer: attackers (a fraction of the ships, by
+     * id) harass docked enemies without fleeing, the rest mine.
+     */
+    namespace simple_attack_and_miner {
+        using namespace std;
+        using namespace hlt;
+
+        class Bot {
+        public:
+            Bot(const PlayerId player_id, const Map& initial_map) : player_id(player_id) {
+                // Decide on number of attackers to miners
+                if(initial_map.ship_map.size() == 4){
+                    // Play a more econ game when there are a lot of players.
+                    DENOMINATOR_OF_FRACTION_OF_ATTACKER = 10000;
+                } else {
+                    // Calculate the proportion of attackers to miners based on map size; at least 1 on small maps
+                    DENOMINATOR_OF_FRACTION_OF_ATTACKER = std::max(1, 4 * ((initial_map.map_height * initial_map.map_width)/(240*160)));
+                }
+
+                // We now have 1 full minute to analyse the initial map.
+                HLT_LOG(Info, "width: " << initial_map.map_width
+                        << "; height: " << initial_map.map_height
+                        << "; players: " << initial_map.ship_map.size()
+                        << "; my ships: " << initial_map.ship_map.at(player_id).size()
+                        << "; planets: " << initial_map.planets.size());
+            }
+
+            void operator()(const Map& map, vector<Move>& moves) {
+                arena.reset();
+                navigation::begin_turn(map);
+                DistanceCache distances(map, player_id, &arena);
+
+                const vector<Ship> &my_ships = map.ships.at(player_id);
+                for (int i = 0; i < (int) my_ships.size(); ++i) {
+                    // Send a fraction of the ships to be attackers, and the rest to be miners
+                    if(my_ships[i].entity_id % DENOMINATOR_OF_FRACTION_OF_ATTACKER == 0){
+                        // Be an attacker
+                        attacker(my_ships[i], map, distances, moves);
+                    } else {
+                        // Be a miner
+                        miner(my_ships[i], map, distances, moves);
+                    }
+                }
+            }
+
+        private:
+            PlayerId player_id;
+            int DENOMINATOR_OF_FRACTION_OF_ATTACKER = 4;
+            /// This turn's scratch, such as the distance tables.
+            Arena arena;
+
+            void miner(const Ship &ship, const Map &map, DistanceCache &distances, vector<Move> &moves) {
+                bool hasCommand = false;
+                if (ship.docking_status != hlt::ShipDockingStatus::Undocked) {
+                    return;
+                }
+                for (const hlt::Planet* planet_ptr : distances.planets_by_distance(ship)) {
+                    const hlt::Planet& planet = *planet_ptr;
+                    // Skip over this planet if it is owned by an opponent, or I own it and it is full
+                    // This will prioritize docking not owned planets
+                    if (planet.owned && (planet.owner_id != player_id || planet.is_full())) {
+                        continue;
+                    }
+
+                    if (ship.can_dock(planet) && !hasCommand) {
+                        if ((!planet.owned || planet.owner_id == player_id)){
+                            moves.push_back(hlt::Move::dock(ship.entity_id, planet.entity_id));
+                            hasCommand = true;
+                            break;
+                        } else {
+                            // Already at the planet, but currently someone else owns the planet. Thus, move to attacking
+                            break;
+                        }
+                    }
+
+                    const hlt::possibly<hlt::Move> move =
+                    hlt::navigation::navigate_ship_to_dock(map, ship, planet, hlt::constants::MAX_SPEED);
+                    if (move.second && !hasCommand) {
+                        moves.push_back(move.first);
+                        hasCommand = true;
+                        break;
+                    }
+                }
+                if (!hasCommand){
+                    // Attack nearest docked enemy ship
+                    for(const Ship* enemy_ptr: distances.enemies_by_distance(ship)) {
+                        const Ship& enemy = *enemy_ptr;
+                        if(enemy.docking_status == ShipDockingStatus::Undocked) {
+                            continue;
+                        }
+                        const hlt::possibly<hlt::Move> move =
+                        hlt::navigation::navigate_ship_to_dock(map, ship, enemy, hlt::constants::MAX_SPEED);
+                        if (move.second && !hasCommand) {
+                            moves.push_back(move.first);
+                            hasCommand = true;
+                            break;
+                        }
+                    }
+                }
+            }
+
+
+            void attacker(const Ship &ship, const Map &map, DistanceCache &distances, vector<Move> &moves) {
+                bool hasCommand = false;
+                if (ship.docking_status != hlt::ShipDockingStatus::Undocked) {
+                    moves.push_back(Move::undock(ship.entity_id));
+                    hasCommand = true;
+                    return;
+                }
+
+                if (!hasCommand){
+                    // Attack nearest enemy ship
+
+                    if(distances.has_docked_enemies()){
+                        // harass docked enemy ships, nearest first
+                        for(const Ship* enemy_ptr: distances.enemies_by_distance(ship)) {
+                            const Ship& enemy = *enemy_ptr;
+                            if(enemy.docking_status == ShipDockingStatus::Undocked) {
+                                continue;
+                            }
+                            const hlt::possibly<hlt::Move> move =
+                            hlt::navigation::navigate_ship_to_dock(map, ship, enemy, hlt::constants::MAX_SPEED);
+                            if (move.second && !hasCommand) {
+                                moves.push_back(move.first);
+                                hasCommand = true;
+                                break;
+                            }
+                        }
+                        return;
+                    }
+                    else {
+                        // All enemy ships, nearest first
+                        for(const Ship* enemy_ptr: distances.enemies_by_distance(ship)) {
+                            const hlt::possibly<hlt::Move> move =
+                            hlt::navigation::navigate_ship_to_dock(map, ship, *enemy_ptr, hlt::constants::MAX_SPEED);
+                            if (move.second && !hasCommand) {
+                                moves.push_back(move.first);
+                                hasCommand = true;
+                                break;
+                            }
+                        }
+                        return;
+                    }
+                }
+            }
+
+        };
+
+        static Strategy create(const PlayerId player_id, const Map& initial_map) {
+            return Bot(player_id, initial_map);
+        }
+    }
+}
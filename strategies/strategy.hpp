@@ -0,0 +1,48 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "hlt/hlt.hpp"
+#include "hlt/world.hpp"
+
+namespace strategies {
+    /**
+     * One bot's turn: append the moves it sends for this map to moves, which
+     * the caller keeps (and clears) from turn to turn so its storage is reused.
+     */
+    typedef std::function<void(const hlt::Map&, std::vector<hlt::Move>&)> Strategy;
+
+    /**
+     * Sets a bot up for one game, given its player id and the pre-game map.
+     * Anything the bot keeps between turns lives inside the returned Strategy.
+     */
+    typedef std::function<Strategy(hlt::PlayerId, const hlt::Map&)> StrategyFactory;
+
+    /// Play a whole game against the engine over stdin/stdout. The body of a bot's main().
+    static int play(const std::string& bot_name, const StrategyFactory& factory) {
+        const hlt::Metadata metadata = hlt::initialize(bot_name);
+        Strategy strategy;
+        {
+            HLT_PROFILE_SCOPE(Strategy);
+            strategy = factory(metadata.player_id, metadata.initial_map);
+        }
+        hlt::profile::Profiler::end_turn();
+
+        std::vector<hlt::Move> moves;
+        for (;;) {
+            const hlt::Map& map = hlt::in::get_world().map();
+            moves.clear();
+            {
+                HLT_PROFILE_SCOPE(Strategy);
+                strategy(map, moves);
+            }
+            if (!hlt::out::send_moves(moves)) {
+                HLT_LOG(Error, "send_moves failed; exiting");
+                return 0;
+            }
+            hlt::profile::Profiler::end_turn();
+        }
+    }
+}
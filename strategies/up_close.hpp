@@ -0,0 +1,102 @@
+#pragma once
+
+#include <memory>
+
+#include "hlt/assignment.hpp"
+#include "hlt/distance_cache.hpp"
+#include "hlt/flow_field.hpp"
+#include "hlt/move_planner.hpp"
+#include "hlt/worker_pool.hpp"
+#include "strategies/common.hpp"
+#include "strategies/strategy.hpp"
+
+namespace strategies {
+    /// UpClose: every ship docks on the free spot it was assigned, or goes after docked enemies.
+    namespace up_close {
+        using namespace std;
+        using namespace hlt;
+
+        class Bot {
+        public:
+            Bot(const PlayerId player_id, const Map& initial_map) :
+                    player_id(player_id),
+                    workers(std::make_shared<hlt::WorkerPool>(hlt::WorkerPool::default_threads())),
+                    planner(workers),
+                    routes(planner, initial_map)
+            {
+                // We now have 1 full minute to analyse the initial map.
+                HLT_LOG(Info, "width: " << initial_map.map_width
+                        << "; height: " << initial_map.map_height
+                        << "; players: " << initial_map.ship_map.size()
+                        << "; my ships: " << initial_map.ship_map.at(player_id).size()
+                        << "; planets: " << initial_map.planets.size());
+            }
+
+            void operator()(const Map& map, std::vector<hlt::Move>& moves) {
+                arena.reset();
+                navigation::begin_turn(map);
+                routes.begin_turn(map, player_id);
+                hlt::DistanceCache distances(map, player_id, &arena);
+
+                // The free docking spots are shared out between all undocked ships at once...
+                const std::vector<hlt::Ship>& my_ships = map.ships.at(player_id);
+                undocked.clear();
+                undocked_index.assign(my_ships.size(), -1);
+                for (size_t i = 0; i < my_ships.size(); ++i) {
+                    if (my_ships[i].docking_status == hlt::ShipDockingStatus::Undocked) {
+                        undocked_index[i] = static_cast<int>(undocked.size());
+                        undocked.push_back(&my_ships[i]);
+                    }
+                }
+                assignment.solve(map, player_id, undocked);
+
+                // ...then every ship picks its targets on its own, possibly on another thread...
+                planner.reset(my_ships.size());
+                docks.assign(my_ships.size(), hlt::possibly<hlt::Move>(hlt::Move::noop(), false));
+                workers->run(my_ships.size(), [&](const size_t i) {
+                    decide(i, my_ships[i], distances);
+                });
+
+                // ...then docks are sent and paths planned in ship order.
+                for (const hlt::possibly<hlt::Move>& dock : docks) {
+                    if (dock.second) {
+                        moves.push_back(dock.first);
+                    }
+                }
+                planner.plan(map, moves);
+            }
+
+        private:
+            PlayerId player_id;
+            std::shared_ptr<hlt::WorkerPool> workers;
+            hlt::MovePlanner planner;
+            common::Routes routes;
+            std::vector<hlt::possibly<hlt::Move>> docks;
+            hlt::PlanetAssignment assignment;
+            /// The undocked ships, in ship order, as given to the assignment.
+            std::vector<const hlt::Ship*> undocked;
+            /// Index into undocked of each of my ships, or -1.
+            std::vector<int> undocked_index;
+            /// This turn's scratch, such as the distance tables.
+            hlt::Arena arena;
+
+            // Runs on worker threads: reads the turn's state, and only writes the ship's slot.
+            void decide(const size_t slot, const hlt::Ship& ship, hlt::DistanceCache& distances) {
+                if (ship.docking_status != hlt::ShipDockingStatus::Undocked) {
+                    return;
+                }
+                planner.request(slot, ship, 0);
+                const hlt::Planet* assigned = assignment.planet_of(undocked_index[slot]);
+                docks[slot] = common::add_miner_targets(planner, slot, ship, assigned, distances, *routes.graph, [&](const hlt::Planet& planet) {
+                    // Skip over this planet if it is owned by an opponent, or I own it and it is full
+                    return planet.owned && (planet.owner_id != player_id || planet.is_full())
+                           ? common::Fallback::Skip : common::Fallback::Take;
+                });
+            }
+        };
+
+        static Strategy create(const PlayerId player_id, const Map& initial_map) {
+            return Bot(player_id, initial_map);
+        }
+    }
+}